@@ -0,0 +1,192 @@
+// microbenchmarks of the engine's kernels over a fixed corpus of positions: every iteration of a kernel benchmark
+// handles one position (or square, or move) of the corpus, so the reported time is the cost of a single call; an
+// iteration of a search benchmark searches the whole corpus (see searchCorpus())
+
+#include "othello/othello.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// positions reached in games of a depth 2 engine with one move in four played at random (see positionToText),
+// midgame positions are taken 20-31 plies into the game, endgame positions have 11 or 12 empty squares
+const char * const MIDGAME_POSITIONS[] = {
+    "----w-------w-----bww-----wbw--b--wbwwwb--wwbw-b--ww--w--------w b",
+    "wb-------b------wbwww----b-ww-w--bbbbw-----wbw-----wb------wbw-- w",
+    "-----------w------bww-b---wwbb----wwbbbb----wwbb-----bbb---www-b w",
+    "------------------wwb-bw-bbbb-ww--wbbwbw----bbww-----www-----www w",
+    "---wwwww---wbbb----wbbbb---wb-b---wwwbb-----bbb-----b-b--------b b",
+    "---------------w--bw-bbw---www-w--bwwwww--bbbbb---wwbb---wwww--- w",
+    "-----------w-b-w---wwwww---wbwww--bbwwww--bbbwwb-----wwb------wb b",
+    "b------w-bwb--w---bwbwbb-bbbbbbb---bbwbb----bb-b----bw-b-----w-- w",
+    "----w------bw-----wwww-b--bwwwb---wbwbwb-wb-b-bw--bbbbbb--w-w--- b",
+    "-------w------w------ww--bbbbbb---bww-b-wbwwwbbwbbb-b-b-w--bbbbb w",
+    "-bbb--w---bbbbww---bb-ww---bbwbw-wwbwww---wwbb-b--wwb-b--------- b",
+    "wwwwww--bbbbww--wbbwbbbbwwbwww--wwwbwwb-b---b------------------- w",
+};
+
+const char * const ENDGAME_POSITIONS[] = {
+    "bbb-w---bbbbw---bbwbw--wbwwbwwww--wbbwwwwwwbwbwwwwbbbbwwwwwbbwww b",
+    "wwwwww--bwbbwb-wwbwwb--wwwwbbwbwbwbbwbbwbbbwwbww-bbbb----wwwww-- b",
+    "bbbbbw--bbbbbb--bbwwbwbbbwwbbwbb-wwbbwbb--wbbwbb--bbbbbb--bbbbbb w",
+    "w-bbb---wwwwbw--wwwbbwwwwwbwbwww-wwwbwwwbwwwbwww-w-bbwww---wbwww b",
+    "wwwwwwwwwwbwwwwwwwwwbwwwwwwwwwwwwwwwwwww---wwwww---wbbww----b-bb b",
+    "-----wbb--w--bbbbwwwbbbbw-wwwbbb-wwwbwbb-bbbbbbbwbbwwbbwbbbbbbbb b",
+    "--bwwwbb--wwwbbb--wwbwbb-bwbbbbbb-wbbbbbbwwbbwbbbb-bbbbbb--wbbbb w",
+    "bwwwwwww-bbwwwww-bbwwbwbwwbwwwbb--bbwbbb--bwbb-bbbb-bb-bw--bbbb- b",
+    "-bbbbb-b-wwbwwww--bbbbww-bbwbwww--bbwwww-bbwbwwwb-wwwwww-wwwwwww w",
+    "--w-w--w--wwwww---wbwbbbwwwbbwbb--wbwbbbwbwbbwbbbwwbbwbbwwwbbbbb b",
+    "wwwwwbbb--wwbbbb--wwwbwb-bbbbbwbbbbwbbwb-bbbwwwb--bbwwbb--bbbb-b w",
+    "wwwwww-bbwbbwwb-wwbbbbwbwwwwbwwbwwwwwbwbbwwwb-b--w-bb--bw-bbb--- b",
+};
+
+struct Position
+{
+    char board[8][8];
+    char player;
+};
+
+// the corpus picked by the benchmark's argument: 0 for midgame, 1 for endgame positions
+std::vector<Position> corpus(int endgame){
+    std::vector<Position> positions;
+    for(const char * text : endgame ? ENDGAME_POSITIONS : MIDGAME_POSITIONS){
+        Position position;
+        if(!positionFromText(text, position.board, position.player))
+            throw std::logic_error{std::string("bad benchmark position ") + text};
+        positions.push_back(position);
+    }
+    return positions;
+}
+
+// a position of the corpus together with a square on it
+struct Square
+{
+    Position position;
+    int row;
+    int col;
+};
+
+// every empty square of the corpus
+std::vector<Square> emptySquaresOf(const std::vector<Position> & positions){
+    std::vector<Square> squares;
+    for(const Position & position : positions)
+        for(int i = 0; i < 8; ++i)
+            for(int j = 0; j < 8; ++j)
+                if(position.board[i][j] == '-')
+                    squares.push_back(Square{position, i, j});
+    return squares;
+}
+
+// every legal move of the corpus
+std::vector<Square> legalMovesOf(std::vector<Position> positions){
+    std::vector<Square> moves;
+    for(Position & position : positions)
+        for(int square : calculateLegalMoves(position.board, position.player))
+            moves.push_back(Square{position, square / 8, square % 8});
+    return moves;
+}
+
+void BM_CalculateLegalMoves(benchmark::State & state){
+    std::vector<Position> positions = corpus(state.range(0));
+    std::size_t i = 0;
+    for(auto _ : state){
+        Position & position = positions[i];
+        i = (i + 1 == positions.size()) ? 0 : i + 1;
+        MoveList move_list = calculateLegalMoves(position.board, position.player);
+        benchmark::DoNotOptimize(move_list);
+    }
+}
+BENCHMARK(BM_CalculateLegalMoves)->ArgName("endgame")->Arg(0)->Arg(1);
+
+void BM_IsFlippable(benchmark::State & state){
+    std::vector<Square> squares = emptySquaresOf(corpus(state.range(0)));
+    std::size_t i = 0;
+    for(auto _ : state){
+        Square & square = squares[i];
+        i = (i + 1 == squares.size()) ? 0 : i + 1;
+        bool flippable = isFlippable(square.position.board, square.row, square.col, square.position.player);
+        benchmark::DoNotOptimize(flippable);
+    }
+}
+BENCHMARK(BM_IsFlippable)->ArgName("endgame")->Arg(0)->Arg(1);
+
+// includes copying the 64 byte board the move is made on
+void BM_MakeMove(benchmark::State & state){
+    std::vector<Square> moves = legalMovesOf(corpus(state.range(0)));
+    std::size_t i = 0;
+    char board[8][8];
+    for(auto _ : state){
+        const Square & move = moves[i];
+        i = (i + 1 == moves.size()) ? 0 : i + 1;
+        std::memcpy(board, move.position.board, 8 * 8 * sizeof(char));
+        makeMove(board, move.row, move.col, move.position.player);
+        benchmark::DoNotOptimize(board);
+    }
+}
+BENCHMARK(BM_MakeMove)->ArgName("endgame")->Arg(0)->Arg(1);
+
+void BM_GetScore(benchmark::State & state){
+    std::vector<Position> positions = corpus(state.range(0));
+    std::size_t i = 0;
+    for(auto _ : state){
+        Position & position = positions[i];
+        i = (i + 1 == positions.size()) ? 0 : i + 1;
+        int score = getScore(position.board, position.player);
+        benchmark::DoNotOptimize(score);
+    }
+}
+BENCHMARK(BM_GetScore)->ArgName("endgame")->Arg(0)->Arg(1);
+
+void BM_Heuristic(benchmark::State & state){
+    std::vector<Position> positions = corpus(state.range(0));
+    std::size_t i = 0;
+    for(auto _ : state){
+        Position & position = positions[i];
+        i = (i + 1 == positions.size()) ? 0 : i + 1;
+        int value = heuristic(position.board);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_Heuristic)->ArgName("endgame")->Arg(0)->Arg(1);
+
+// searches every position of a corpus once per iteration, without a transposition table so that every search
+// starts from the same state; items are positions, so items_per_second is the number of searches per second
+void searchCorpus(benchmark::State & state, const std::vector<Position> & corpus, const SearchLimits & limits){
+    EngineConfig config;
+    std::atomic<bool> stop(false);
+    std::vector<Position> positions = corpus;
+    long long nodes = 0;
+    for(auto _ : state){
+        for(Position & position : positions)
+            nodes += search(position.board, position.player, limits, config, stop).nodes;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(positions.size()));
+    state.counters["nodes"] = benchmark::Counter(static_cast<double>(nodes) / positions.size(),
+                                                 benchmark::Counter::kAvgIterations);
+    state.counters["nps"] = benchmark::Counter(static_cast<double>(nodes), benchmark::Counter::kIsRate);
+}
+
+// fixed depth searches of the midgame positions
+void BM_Search(benchmark::State & state){
+    SearchLimits limits;
+    limits.depth = static_cast<int>(state.range(0));
+    searchCorpus(state, corpus(0), limits);
+}
+BENCHMARK(BM_Search)->ArgName("depth")->Arg(2)->Arg(4)->Arg(6)->Unit(benchmark::kMillisecond);
+
+// exact solves of the endgame positions
+void BM_SolveEndgame(benchmark::State & state){
+    SearchLimits limits;
+    limits.depth = 60; // reaches the end of the game, so the search solves
+    searchCorpus(state, corpus(1), limits);
+}
+BENCHMARK(BM_SolveEndgame)->Unit(benchmark::kMillisecond);
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+# profile-guided build, run by the pgo target (cmake --build <dir> --target pgo): builds an instrumented othello in
+# BINARY_DIR, plays the training workload below with it and then rebuilds BINARY_DIR with the profile applied.
+# Both builds share BINARY_DIR because GCC finds the profile of an object file by the object's path.
+#
+# expects SOURCE_DIR, BINARY_DIR, GENERATOR and CXX_COMPILER to be set with -D
+
+set(profile_dir "${BINARY_DIR}/profile")
+
+function(run)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY "${BINARY_DIR}" RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        string(REPLACE ";" " " command "${ARGN}")
+        message(FATAL_ERROR "pgo: \"${command}\" failed (${result})")
+    endif()
+endfunction()
+
+function(configure phase)
+    run("${CMAKE_COMMAND}" -S "${SOURCE_DIR}" -B "${BINARY_DIR}" -G "${GENERATOR}"
+        -DCMAKE_CXX_COMPILER=${CXX_COMPILER} -DCMAKE_BUILD_TYPE=Release
+        -DOTHELLO_PGO=${phase} -DOTHELLO_PGO_PROFILE_DIR=${profile_dir})
+endfunction()
+
+file(MAKE_DIRECTORY "${BINARY_DIR}")
+file(REMOVE_RECURSE "${profile_dir}")
+
+message(STATUS "pgo: building the instrumented engine")
+configure(generate)
+run("${CMAKE_COMMAND}" --build "${BINARY_DIR}" --target othello_cli --parallel)
+
+# the training workload: deterministic single threaded matches (fixed seeds, depth limits and no time limits) that
+# run the alpha-beta search with and without MTD(f), the transposition table, ProbCut, the endgame solver and the
+# full game tree minimax
+message(STATUS "pgo: running the training workload")
+run("${BINARY_DIR}/othello" tournament --engine-a "name=a,depth=7,tt=16" --engine-b "name=b,depth=6,mtdf=1,tt=16"
+    --pairs 6 --plies 8 --threads 1 --seed 1)
+run("${BINARY_DIR}/othello" tournament --engine-a "name=tree,alphabeta=0,depth=4" --engine-b "name=ab,depth=4,probcut=0"
+    --pairs 2 --threads 1 --seed 1)
+
+message(STATUS "pgo: building with the profile")
+configure(use)
+run("${CMAKE_COMMAND}" --build "${BINARY_DIR}" --parallel)
+message(STATUS "pgo: done, the optimized build is in ${BINARY_DIR}")
@@ -0,0 +1,354 @@
+// board representation (char[8][8] of 'b', 'w' and '-'), move generation and position hashing
+#ifndef OTHELLO_BOARD_H
+#define OTHELLO_BOARD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// flips appropriate pieces after a disc is placed down (called after verifying the move isFlippable)
+// the player is a template parameter so the search gets one copy per color without tests on the color
+template<char PLAYER>
+void flip(char (&board)[8][8], int row, int col){
+    // declare a list of positions of discs that will be flipped
+    // e.g. {1, 2} means disc at location board[0][1] & board[0][2] will be flipped (square = row * 8 + col)
+    uint8_t discs_to_flip[64];
+    int flip_count = 0;
+
+    constexpr char player = PLAYER;
+    constexpr char otherPlayer = (PLAYER == 'b') ? 'w' : 'b';
+
+    // use deltas to find all 8 surrounding positions
+    int surroundingPosDeltas[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, // 3 positions above
+                                      {0, -1}, {0, 1}, // 2 positions on same row
+                                      {1, -1}, {1, 0}, {1, 1}}; // 3 positions below
+
+    // for every delta representing a neighboring position...
+    for(auto deltas : surroundingPosDeltas){
+        //std::cout << "deltas: [" << deltas[0] << ", " << deltas[1] << "]" << '\n';
+
+        // save what row/col currently on
+        int curr_row = row + deltas[0];
+        int curr_col = col + deltas[1];
+
+        // ignore if this goes off of the board
+        if(curr_row > 7 || curr_row < 0 || curr_col > 7 || curr_col < 0)
+            continue;
+
+
+        // save character in this position
+        char char_in_pos = board[curr_row][curr_col];
+
+        // use this variable to save whether or not a line of pieces should be flipped
+        bool flip_this_direction = false;
+
+        // if the character in this delta position is the opponent's piece...
+        if(char_in_pos == otherPlayer){
+            //std::cout << "Found other player at location: [" << curr_row << ", " << curr_col << "], " << char_in_pos << '\n';
+
+            // continue in this delta position until the next character is no longer the opponent's or you go off the board
+            while(char_in_pos == otherPlayer){
+                curr_row += deltas[0];
+                curr_col += deltas[1];
+
+                // check to see if new position is off board
+                if(curr_row > 7 || curr_row < 0 || curr_col > 7 || curr_col < 0)
+                    break;
+
+                // save the character
+                char_in_pos = board[curr_row][curr_col];
+            }
+
+            // if the player's piece is found after traversing over the opponent's piece(s), we know we will be flipping
+            if(char_in_pos == player)
+                flip_this_direction = true;
+
+            // if we found out we should be flipping...
+            if(flip_this_direction){
+                // save current position
+                curr_row = row + deltas[0];
+                curr_col = col + deltas[1];
+                char_in_pos = board[curr_row][curr_col];
+
+                // traverse over the opponent's pieces, while saving the positions to the big list to be flipped later
+                while(char_in_pos == otherPlayer){
+                    //std::cout << "flipping [" << curr_row << ", " << curr_col << "]\n";
+                    discs_to_flip[flip_count++] = static_cast<uint8_t>(curr_row * 8 + curr_col);
+                    curr_row += deltas[0];
+                    curr_col += deltas[1];
+
+                    // save next character
+                    char_in_pos = board[curr_row][curr_col];
+                }
+
+            }
+        }
+    }
+
+    // after we've collecting the row/col of all discs to flipped, flip them to the current player's color/character
+    for(int i = 0; i < flip_count; ++i)
+        board[discs_to_flip[i] / 8][discs_to_flip[i] % 8] = player;
+}
+
+void flip(char (&board)[8][8], int row, int col, char player);
+
+// a move "isFlippable" if it causes pieces to flip
+template<char PLAYER>
+bool isFlippable(char board[8][8], int row, int col) {
+    constexpr char player = PLAYER;
+    constexpr char otherPlayer = (PLAYER == 'b') ? 'w' : 'b';
+
+    // Check all 8 surround positions
+    int surroundingPosDeltas[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, // 3 positions above
+                                      {0, -1}, {0, 1}, // 2 positions on same row
+                                      {1, -1}, {1, 0}, {1, 1}}; // 3 positions below
+
+    // for every delta of the surrounding positions
+    for(auto deltas : surroundingPosDeltas){
+
+        // skip if the position is off of game board
+        if(row+deltas[0] > 7 || row+deltas[0] < 0 || col+deltas[1] > 7 || col+deltas[1] < 0){
+            continue;
+        }
+
+        //std::cout << "deltas: [" << deltas[0] << ", " << deltas[1] << "]" << '\n';
+        char char_in_pos = board[row+deltas[0]][col+deltas[1]]; // grab the character in that spot
+
+        // if the character in this delta spot is the opponent's piece...
+        if(char_in_pos == otherPlayer){
+            // save spot's row and col #
+            int curr_row = row + deltas[0];
+            int curr_col = col + deltas[1];
+
+            //std::cout << "Found other player at location: [" << curr_row << ", " << curr_col << "], " << char_in_pos << '\n';
+
+            //continue along this delta trajectory until you stop seeing the opponent's pieces
+            while(char_in_pos == otherPlayer){
+                curr_row += deltas[0];
+                curr_col += deltas[1];
+
+                // check to see if new position is off board
+                if(curr_row > 7 || curr_row < 0 || curr_col > 7 || curr_col < 0)
+                    break;
+
+                // save the next character
+                char_in_pos = board[curr_row][curr_col];
+            }
+
+            // if the player's piece is seen after one (+more) of the opponent's pieces, the original move is a flippable one
+            if(char_in_pos == player)
+                return true;
+        }
+    }
+
+    // if no flippable spot is found after checking all surrounding positions, the original move is not a flippable one
+    return false;
+}
+
+bool isFlippable(char board[8][8], int row, int col, char player);
+
+// set board[row][col] to player's piece, and flip appropriate pieces
+template<char PLAYER>
+void makeMove(char (&board)[8][8], int row, int col){
+    //std::cout << "Updating row: " << row << " col: " << col << '\n';
+    // set provided row/col position to the player's character piece
+    board[row][col] = PLAYER;
+
+    // flip discs from resulting move
+    flip<PLAYER>(board, row, col);
+}
+
+void makeMove(char (&board)[8][8], int row, int col, char player);
+
+// the discs (bit row * 8 + col) that player placing a disc on row/col would flip, without changing the board
+// (bitboardFlips() on the char board)
+uint64_t flipMask(char board[8][8], int row, int col, char player);
+
+const uint8_t NO_MOVE = 64; // square standing for no move: a pass, or a player without a legal move
+
+const int MAX_MOVES = 33; // most legal moves a player can have in any position reachable in a game
+
+// the legal moves of a position, kept on the stack so that generating them never allocates
+// moves are squares (row * 8 + col) in board order until the search reorders them
+struct MoveList
+{
+    uint8_t squares[MAX_MOVES];
+    int count = 0;
+
+    void push(int square){ squares[count++] = static_cast<uint8_t>(square); }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    int row(int i) const { return squares[i] / 8; }
+    int col(int i) const { return squares[i] % 8; }
+    const uint8_t * begin() const { return squares; }
+    const uint8_t * end() const { return squares + count; }
+
+    bool contains(int square) const {
+        return std::find(begin(), end(), square) != end();
+    }
+
+    // move entry i to the front, the others keep their order
+    void moveToFront(int i){
+        std::rotate(squares, squares + i, squares + i + 1);
+    }
+
+    // move the entry for square to the front if it is in the list
+    void moveSquareToFront(int square){
+        for(int i = 1; i < count; ++i){
+            if(squares[i] == square){
+                moveToFront(i);
+                return;
+            }
+        }
+    }
+};
+
+// used to algorithmically calculate legal moves belonging to passed-in player
+template<char PLAYER>
+MoveList calculateLegalMoves(char board[8][8]) {
+
+    // declare main move list
+    MoveList move_list;
+
+    for(int i = 0; i < 8; ++i){
+        for(int j = 0; j < 8; ++j){
+            // first make sure the spot is empty
+            if(board[i][j] == '-'){
+
+                // check to see if placing a piece there will flip one (+more) of the opponent's pieces
+                if(isFlippable<PLAYER>(board, i, j)){
+
+                    // if so, add the move's square to the move list
+                    move_list.push(i * 8 + j);
+                }
+
+            }
+        }
+    }
+
+    return move_list;
+
+}
+
+MoveList calculateLegalMoves(char board[8][8], char player);
+
+// for a given board configuration, determine if a move is legal (searches through a previously generated movelist)
+bool isLegalMove(char board[8][8], const MoveList & move_list, int row, int col, char player);
+
+// return a list of all the moves available to black
+MoveList getBlackLegalMoves(char board[8][8]);
+
+// return a list of all the moves available to white
+MoveList getWhiteLegalMoves(char board[8][8]);
+
+// for the passed-in player, print all legal moves (displayed on board update)
+void printLegalMoves(char board[8][8], char player);
+
+// pass in a generated move list to "pretty print" them
+void printLegalMoves(const MoveList & move_list);
+
+// overload the << operator to "pretty print" the board
+std::ostream& operator<<(std::ostream& os, const char board[8][8]);
+
+// used to determine if the game is ended, makes sure at least 1 player has a move to make
+bool isGameOver(char board[8][8]);
+
+// go through whole board, and count pieces of passed-in player
+int getScore(char board[8][8], char player);
+
+// "pretty print" the winner of the game at the end of the game loop
+void printWinner(char (&board)[8][8]);
+
+// pack the board into one 64-bit mask per player, bit (row * 8 + col) is set when that player owns the square
+void toBitboards(char board[8][8], uint64_t & black, uint64_t & white);
+
+// inverse of toBitboards()
+void fromBitboards(uint64_t black, uint64_t white, char (&board)[8][8]);
+
+const uint64_t NOT_COL_A = 0xfefefefefefefefeULL; // every square but those of column 0
+
+const uint64_t NOT_COL_H = 0x7f7f7f7f7f7f7f7fULL; // every square but those of column 7
+
+// move every square of x one step in direction (0-7: east, west, south, north, south east, north west, south west,
+// north east; direction ^ 1 is the opposite one), squares leaving the board are dropped
+inline uint64_t shiftBitboard(uint64_t x, int direction){
+    switch(direction){
+        case 0: return (x << 1) & NOT_COL_A;
+        case 1: return (x >> 1) & NOT_COL_H;
+        case 2: return x << 8;
+        case 3: return x >> 8;
+        case 4: return (x << 9) & NOT_COL_A;
+        case 5: return (x >> 9) & NOT_COL_H;
+        case 6: return (x << 7) & NOT_COL_H;
+        default: return (x >> 7) & NOT_COL_A;
+    }
+}
+
+// opponent discs flipped by a move of own on square (row * 8 + col), the board's flip() on bitboards
+inline uint64_t bitboardFlips(uint64_t own, uint64_t opp, int square){
+    uint64_t flipped = 0;
+    for(int direction = 0; direction < 8; ++direction){
+        uint64_t line = 0;
+        uint64_t x = shiftBitboard(uint64_t(1) << square, direction);
+        while(x & opp){
+            line |= x;
+            x = shiftBitboard(x, direction);
+        }
+        if(x & own)
+            flipped |= line;
+    }
+    return flipped;
+}
+
+// set up the board with the 4 starting discs in the center
+void initializeBoard(char (&board)[8][8]);
+
+// name of a square in the usual Othello notation: column letter 'a'-'h' followed by row number '1'-'8'
+std::string squareName(int row, int col);
+
+// parse a square name such as "f5" (either case) into a row/col, returns false if it isn't one
+bool parseSquare(const std::string & name, int & row, int & col);
+
+// scramble the bits of a 64-bit value (splitmix64 finalizer)
+uint64_t mixBits(uint64_t x);
+
+// 64-bit key identifying a board configuration together with the player to move
+uint64_t hashPosition(uint64_t black, uint64_t white, char player);
+
+uint64_t hashPosition(char board[8][8], char player);
+
+// the 8 symmetries of the board (identity, rotations and reflections) are numbered 0-7 and applied to bitboards as
+// a combination of: bit 2 = transpose (swap rows and columns), bit 1 = flip rows, bit 0 = mirror columns
+
+// flip the board upside down (row i becomes row 7 - i), every row is one byte so this is a byte swap
+uint64_t flipVertical(uint64_t x);
+
+// mirror the board left to right (col j becomes col 7 - j) by reversing the bits of every byte
+uint64_t mirrorHorizontal(uint64_t x);
+
+// transpose the board (square (row, col) moves to (col, row)) with three delta swaps
+uint64_t transposeBitboard(uint64_t x);
+
+// apply symmetry number transform (0-7) to a bitboard
+uint64_t transformBitboard(uint64_t x, int transform);
+
+// where square (row * 8 + col) ends up after transformBitboard(x, transform)
+int transformSquare(int square, int transform);
+
+// inverse of transformSquare, maps a square of the transformed board back onto the original board
+int untransformSquare(int square, int transform);
+
+// replace black/white with the smallest of the 8 symmetric variants of the position, so that all variants share
+// one representative; returns the transform that maps the original position onto the canonical one
+int canonicalize(uint64_t & black, uint64_t & white);
+
+// hash of the canonical form of the position, identical for all 8 symmetric variants; transform receives the
+// symmetry that maps this board onto the canonical form (use it to translate moves with transformSquare)
+uint64_t canonicalHash(char board[8][8], char player, int & transform);
+
+// number of squares no disc has been placed on yet
+int emptySquares(char board[8][8]);
+
+#endif // OTHELLO_BOARD_H
@@ -0,0 +1,20 @@
+// static evaluation of board configurations
+#ifndef OTHELLO_EVAL_H
+#define OTHELLO_EVAL_H
+
+#include "othello/board.h"
+
+// weights used by heuristic() to value a board configuration, tunable per engine configuration
+struct EvalWeights
+{
+    int mobility = 1; // value of each legal move available
+    int disc = 1; // value of each disc on the board
+    int corner = 10; // value of each occupied corner
+};
+
+const EvalWeights DEFAULT_WEIGHTS;
+
+// heursitic used to give value to varying states of the game
+int heuristic(char board[8][8], const EvalWeights & weights = DEFAULT_WEIGHTS);
+
+#endif // OTHELLO_EVAL_H
@@ -0,0 +1,296 @@
+// on-disk formats: opening books, position/game record files and WTHOR game databases
+#ifndef OTHELLO_FILES_H
+#define OTHELLO_FILES_H
+
+#include "othello/board.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// read-only memory mapping of a whole file, unmapped when the object goes away
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+    ~MappedFile(){ close(); }
+
+    // map the file at path, returns false if it can't be opened (an empty file maps to size() == 0)
+    bool open(const std::string & path);
+
+    void close();
+
+    const unsigned char * data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const unsigned char * data_ = NULL;
+    std::size_t size_ = 0;
+};
+
+// one position of the opening book, records are stored sorted by hash so they can be binary searched
+struct BookEntry
+{
+    uint64_t hash; // canonicalHash() of the position, symmetric positions share one record
+    uint32_t visits; // number of games that reached the position
+    int16_t score; // average final disc difference (side to move minus opponent) after playing move
+    uint8_t move; // best move found for the position, row * 8 + col on the canonical board
+    uint8_t reserved;
+};
+static_assert(sizeof(BookEntry) == 16, "book records are written to disk as-is");
+
+// the book file is a 16 byte header followed by header.count BookEntry records (native byte order)
+struct BookHeader
+{
+    char magic[8]; // "OTHBOOK2"
+    uint64_t count;
+};
+static_assert(sizeof(BookHeader) == 16, "book header is written to disk as-is");
+
+const char BOOK_MAGIC[8] = {'O', 'T', 'H', 'B', 'O', 'O', 'K', '2'};
+
+// an opening book memory mapped from disk, positions are looked up with a binary search over the sorted records
+class OpeningBook
+{
+public:
+    // map the book at path, returns false if the file is missing or isn't a book
+    bool open(const std::string & path);
+
+    // returns the record for hash, or NULL if the position isn't in the book
+    const BookEntry * find(uint64_t hash) const {
+        const BookEntry * end = entries_ + count_;
+        const BookEntry * it = std::lower_bound(entries_, end, hash,
+                                                [](const BookEntry & entry, uint64_t key){ return entry.hash < key; });
+        return (it != end && it->hash == hash) ? it : NULL;
+    }
+
+    std::size_t size() const { return count_; }
+
+private:
+    MappedFile file_;
+    const BookEntry * entries_ = NULL;
+    std::size_t count_ = 0;
+};
+
+// look up the book move (row * 8 + col) for player, returns NO_MOVE if the position isn't in the book
+uint8_t probeBook(const OpeningBook & book, char board[8][8], char player);
+
+// a position packed into 16 bytes: one bitboard per player (see toBitboards) with the player to move folded into
+// the d4 bit of white's bitboard. d4 is one of the 4 starting squares and is never empty in a game, so black's d4
+// bit alone says who owns it and white's d4 bit is free to say whether white is to move
+struct PackedPosition
+{
+    uint64_t black;
+    uint64_t white;
+};
+static_assert(sizeof(PackedPosition) == 16, "packed positions are written to disk as-is");
+
+const uint64_t D4_BIT = uint64_t(1) << (3 * 8 + 3); // bit of board[3][3]
+
+// pack board and player into packed, returns false (and leaves packed alone) for positions with an empty d4,
+// which can be set up by hand but have no packed form
+bool packPosition(char board[8][8], char player, PackedPosition & packed);
+
+void unpackPosition(const PackedPosition & packed, char (&board)[8][8], char & player);
+
+// textual notation: the 64 squares row by row ('b', 'w' or '-'), a space and the player to move
+std::string positionToText(char board[8][8], char player);
+
+// parse the textual notation, 'X'/'*' and 'O' are accepted for black/white and '.' for empty squares as well
+bool positionFromText(const std::string & text, char (&board)[8][8], char & player);
+
+// position files are a 16 byte header followed by header.count PackedPosition records,
+// game files are a 16 byte header followed by header.count games, each stored as its start PackedPosition,
+// a move count and one byte per move (row * 8 + col, passes are implied as in any game record)
+struct RecordFileHeader
+{
+    char magic[8];
+    uint64_t count;
+};
+static_assert(sizeof(RecordFileHeader) == 16, "record file headers are written to disk as-is");
+
+const char POSITION_FILE_MAGIC[8] = {'O', 'T', 'H', 'P', 'O', 'S', '0', '1'};
+
+const char GAME_FILE_MAGIC[8] = {'O', 'T', 'H', 'G', 'A', 'M', '0', '1'};
+
+// zero-copy reader for position files, positions are used straight from the memory mapping
+class PositionFileReader
+{
+public:
+    bool open(const std::string & path);
+
+    const PackedPosition * begin() const { return positions_; }
+    const PackedPosition * end() const { return positions_ + count_; }
+    const PackedPosition & operator[](std::size_t index) const { return positions_[index]; }
+    std::size_t size() const { return count_; }
+
+private:
+    MappedFile file_;
+    const PackedPosition * positions_ = NULL;
+    std::size_t count_ = 0;
+};
+
+// zero-copy reader for game files, games are decoded one after the other with next()
+class GameFileReader
+{
+public:
+    bool open(const std::string & path);
+
+    // decode the next game, moves points into the mapping; returns false after the last game (or a truncated one)
+    bool next(PackedPosition & start, const uint8_t * & moves, int & move_count){
+        if(read_ >= count_ || offset_ + sizeof(PackedPosition) + 1 > file_.size())
+            return false;
+
+        std::memcpy(&start, file_.data() + offset_, sizeof(PackedPosition)); // games are not 16 byte aligned
+        move_count = file_.data()[offset_ + sizeof(PackedPosition)];
+        if(offset_ + sizeof(PackedPosition) + 1 + move_count > file_.size())
+            return false;
+
+        moves = file_.data() + offset_ + sizeof(PackedPosition) + 1;
+        offset_ += sizeof(PackedPosition) + 1 + move_count;
+        read_ += 1;
+        return true;
+    }
+
+    std::size_t size() const { return count_; }
+
+private:
+    MappedFile file_;
+    std::size_t count_ = 0;
+    std::size_t read_ = 0;
+    std::size_t offset_ = 0;
+};
+
+// writes position or game files, the header's record count is filled in by close()
+class RecordFileWriter
+{
+public:
+    RecordFileWriter(const std::string & path, const char (&magic)[8])
+        : out_(path, std::ios::binary | std::ios::trunc) {
+        std::memcpy(header_.magic, magic, sizeof(header_.magic));
+        header_.count = 0;
+        out_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+    }
+
+    ~RecordFileWriter(){
+        if(!out_.is_open())
+            return;
+        try{
+            close();
+        } catch(std::runtime_error &){ // destructors must not throw, call close() to find out about errors
+        }
+    }
+
+    void writePosition(const PackedPosition & position){
+        out_.write(reinterpret_cast<const char *>(&position), sizeof(position));
+        header_.count += 1;
+    }
+
+    // moves are row * 8 + col square indices, at most 60 of them
+    void writeGame(const PackedPosition & start, const std::vector<uint8_t> & moves){
+        if(moves.size() > 60)
+            throw std::length_error{"RecordFileWriter::writeGame(): more than 60 moves"};
+
+        out_.write(reinterpret_cast<const char *>(&start), sizeof(start));
+        out_.put(static_cast<char>(moves.size()));
+        out_.write(reinterpret_cast<const char *>(moves.data()), moves.size());
+        header_.count += 1;
+    }
+
+    // patch the record count into the header and close the file, throws if anything failed to be written
+    void close(){
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+        bool ok = static_cast<bool>(out_);
+        out_.close();
+        if(!ok)
+            throw std::runtime_error{"RecordFileWriter::close(): write failed"};
+    }
+
+private:
+    std::ofstream out_;
+    RecordFileHeader header_;
+};
+
+// check a move taken from a game record, where passes are not written down: if player has no legal move at all
+// the move belongs to the opponent, so player is switched before checking it
+bool recordedMoveIsLegal(char board[8][8], char & player, int row, int col);
+
+// WTHOR database files (.wtb) hold a 16 byte header followed by one 68 byte record per game, all little endian
+const std::size_t WTHOR_HEADER_SIZE = 16;
+
+const std::size_t WTHOR_GAME_SIZE = 68;
+
+// one game of a WTHOR file, moves points straight into the mapped file
+struct WthorGame
+{
+    int tournament; // index into the matching .trn file
+    int black_player; // index into the matching .jou file
+    int white_player;
+    int black_score; // black's discs at the end of the game (empty squares go to the winner)
+    int theoretical_score; // black's discs with perfect play from the point the game was solved
+    const unsigned char * moves; // 60 moves coded as 10 * row + col (both 1-8), 0 after the last move
+};
+
+// streaming reader for WTHOR files, the file is memory mapped and records are decoded on demand
+class WthorReader
+{
+public:
+    // map the file at path, returns false if it is missing or doesn't hold 8x8 game records
+    bool open(const std::string & path);
+
+    std::size_t size() const { return count_; }
+    int year() const { return year_; }
+
+    // decode game number index (0 <= index < size())
+    WthorGame game(std::size_t index) const {
+        const unsigned char * record = file_.data() + WTHOR_HEADER_SIZE + index * WTHOR_GAME_SIZE;
+        WthorGame game;
+        game.tournament = record[0] | (record[1] << 8);
+        game.black_player = record[2] | (record[3] << 8);
+        game.white_player = record[4] | (record[5] << 8);
+        game.black_score = record[6];
+        game.theoretical_score = record[7];
+        game.moves = record + 8;
+        return game;
+    }
+
+private:
+    MappedFile file_;
+    std::size_t count_ = 0;
+    int year_ = 0;
+};
+
+// convert the moves of a WTHOR game into squares (row * 8 + col), returns false if a move code is invalid
+bool wthorMoves(const WthorGame & game, std::vector<uint8_t> & moves);
+
+// replay a WTHOR game with makeMove(), calling callback(board, player, row, col) with every position before its move
+// is made; returns false as soon as a move turns out to be illegal
+template <typename Callback>
+bool replayWthorGame(const WthorGame & game, Callback callback){
+    char board[8][8];
+    initializeBoard(board);
+    char player = 'b';
+
+    for(int i = 0; i < 60 && game.moves[i] != 0; ++i){
+        int row = game.moves[i] / 10 - 1;
+        int col = game.moves[i] % 10 - 1;
+        if(!recordedMoveIsLegal(board, player, row, col))
+            return false;
+
+        callback(board, player, row, col);
+        makeMove(board, row, col, player);
+        player = (player == 'w') ? 'b' : 'w';
+    }
+    return true;
+}
+
+// parse a game transcript such as "f5d6c3d3c4" (whitespace is ignored) into squares (row * 8 + col)
+bool parseTranscript(const std::string & line, std::vector<uint8_t> & moves);
+
+#endif // OTHELLO_FILES_H
@@ -0,0 +1,58 @@
+// game history that can be walked back and forth without replaying the game or copying boards
+#ifndef OTHELLO_HISTORY_H
+#define OTHELLO_HISTORY_H
+
+#include "othello/board.h"
+
+#include <cstdint>
+#include <vector>
+
+// one ply of a game: the square played (NO_MOVE for a pass), who played it and the discs it flipped,
+// which is all that is needed to take the move back or play it again
+struct HistoryEntry
+{
+    uint64_t flips;
+    uint8_t square;
+    char player;
+};
+
+// the moves played on a board, together with the moves taken back with undo() that redo() can play again.
+// undo(), redo() and goTo() only touch the squares the moves placed and flipped (O(flips) per ply), so walking
+// around a long game costs no more than the moves walked over. The board and player to move are owned by the
+// caller and must only be changed through the history while it is in use
+class GameHistory
+{
+public:
+    // play the move for player and record it. If it is the move redo() would play, that is all it does, otherwise
+    // the moves taken back before are forgotten
+    void play(char (&board)[8][8], int row, int col, char player);
+
+    // record that player passes, like play() the moves taken back are kept if the next of them is this pass
+    void pass(char player);
+
+    // take back the last ply and set player to the side that played it, false at the start of the history
+    bool undo(char (&board)[8][8], char & player);
+
+    // play the ply taken back last again and set player to the side to move after it, false if there is none
+    bool redo(char (&board)[8][8], char & player);
+
+    // undo or redo up to ply (0 for the start of the history), returns false if it is out of range
+    bool goTo(char (&board)[8][8], char & player, int ply);
+
+    // forget every move, the current board becomes the start of the history
+    void clear();
+
+    // number of plies (passes included) from the start of the history to the current board
+    int ply() const { return ply_; }
+
+    // number of plies recorded, the ones taken back included
+    int length() const { return static_cast<int>(entries_.size()); }
+
+    const HistoryEntry & operator[](int ply) const { return entries_[ply]; }
+
+private:
+    std::vector<HistoryEntry> entries_;
+    int ply_ = 0; // entries_[0, ply_) are on the board, entries_[ply_, length()) have been taken back
+};
+
+#endif // OTHELLO_HISTORY_H
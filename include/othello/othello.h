@@ -0,0 +1,11 @@
+// the whole engine library: board and move generation, game history, evaluation, search and file formats
+#ifndef OTHELLO_OTHELLO_H
+#define OTHELLO_OTHELLO_H
+
+#include "othello/board.h"
+#include "othello/eval.h"
+#include "othello/files.h"
+#include "othello/history.h"
+#include "othello/search.h"
+
+#endif // OTHELLO_OTHELLO_H
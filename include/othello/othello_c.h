@@ -0,0 +1,83 @@
+/* C interface to the engine library, for calling the engine in-process from other languages (Python ctypes/cffi,
+ * Go cgo, ...). An engine handle keeps a position, its configuration and transposition table and the result of its
+ * last search. A handle may be used by one thread at a time, except for othello_stop(), which any thread may call
+ * while othello_search() runs.
+ *
+ * Squares are numbered row * 8 + col (0 = a1, 63 = h8, see squareName()), OTHELLO_PASS stands for a pass and for
+ * "no move". Scores are from the point of view of the player to move in the searched position. Functions returning
+ * int report failures as OTHELLO_ERROR and leave a message for othello_last_error(). */
+#ifndef OTHELLO_OTHELLO_C_H
+#define OTHELLO_OTHELLO_C_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTHELLO_OK 0
+#define OTHELLO_ERROR (-1)
+#define OTHELLO_PASS (-1)
+
+typedef struct othello_engine othello_engine;
+
+/* reported after every completed iteration of a search */
+typedef struct othello_progress
+{
+    int depth; /* depth of the iteration (empty squares for an exact endgame solve) */
+    int score;
+    int best_move;
+    long long nodes; /* positions visited so far */
+    double seconds; /* time spent so far */
+} othello_progress;
+
+/* progress callback of othello_search(), returning non-zero stops the search */
+typedef int (*othello_progress_callback)(const othello_progress * progress, void * user_data);
+
+/* a new engine with the default configuration, set up at the initial position with black to move; NULL if out of
+ * memory */
+othello_engine * othello_engine_new(void);
+void othello_engine_free(othello_engine * engine);
+
+/* message of the last failed call, "" if there is none; valid until the next call with the same handle */
+const char * othello_last_error(const othello_engine * engine);
+
+/* apply an engine description such as "depth=8,time=500,tt=32" (keys as in parseEngineConfig()), keys left out
+ * keep their defaults; the transposition table is reallocated and emptied */
+int othello_configure(othello_engine * engine, const char * config);
+
+/* set the position from its text notation (64 characters 'b', 'w' or '-' row by row, a space and the player to
+ * move, see positionToText()) or from "startpos" */
+int othello_set_position(othello_engine * engine, const char * position);
+
+/* play square for the player to move; a player without legal moves passes first (passes are implied), an explicit
+ * OTHELLO_PASS is only accepted when the player has no legal move */
+int othello_play(othello_engine * engine, int square);
+
+/* 'b' or 'w' */
+int othello_side_to_move(const othello_engine * engine);
+
+/* write up to capacity legal moves of the player to move into squares, returns how many there are */
+int othello_legal_moves(const othello_engine * engine, int * squares, int capacity);
+
+/* search the current position until depth plies (1-60) or time_ms milliseconds (0 for no time limit) are reached
+ * or othello_stop() is called; callback (may be NULL) gets every completed iteration. In the endgame (see the
+ * endgame key) a depth reaching the end of the game, such as 60, solves the position exactly */
+int othello_search(othello_engine * engine, int depth, int time_ms, othello_progress_callback callback,
+                   void * user_data);
+
+/* ask a running othello_search() to return as soon as possible with the result it has; called while no search is
+ * running, it stops the next one (which then returns after its first iteration) */
+void othello_stop(othello_engine * engine);
+
+/* results of the last othello_search() */
+int othello_best_move(const othello_engine * engine);
+int othello_score(const othello_engine * engine);
+int othello_depth(const othello_engine * engine);
+
+/* write up to capacity moves of the principal variation (best move first) into squares, returns its length */
+int othello_pv(const othello_engine * engine, int * squares, int capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTHELLO_OTHELLO_C_H */
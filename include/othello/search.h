@@ -0,0 +1,362 @@
+// game tree minimax, alpha-beta search with a transposition table, endgame solver and pondering
+#ifndef OTHELLO_SEARCH_H
+#define OTHELLO_SEARCH_H
+
+#include "othello/board.h"
+#include "othello/eval.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int MINIMAX_DEPTH = 5; // depth of the game tree search
+const bool DEBUG_MODE = false;
+const double PROBCUT_CONFIDENCE = 1.5; // selectivity of the search, see EngineConfig::probcut
+const int ENDGAME_EMPTIES = 12; // the search solves positions with this many empty squares or less exactly
+const int ETC_DEPTH = 4; // shallowest search using enhanced transposition cutoffs, 0 for none
+const int ASPIRATION_WINDOW = 8; // half-width of the window around the previous iteration's score, 0 for full windows
+const int TT_MEGABYTES = 64; // size of the transposition table used by the engine protocol and server
+
+class OpeningBook;
+
+// a node which will be part of the game tree, main pieces of info include: state (board configuration as bitboards,
+// see toBitboards()) & associated value; 24 bytes, the children are found through the GameTree holding the node
+struct Node
+{
+    uint64_t black;
+    uint64_t white;
+    uint32_t first_child; // index of the first child in the tree, the others follow it
+    int16_t val; // clamped to the range of int16_t
+    uint8_t child_count;
+    uint8_t move; // square (row * 8 + col) played to reach this node, NO_MOVE for the root and for a pass
+};
+
+// game tree of a fixed depth (built everytime the AI has a turn): all nodes are kept in one 64-byte aligned array in
+// which the children of a node are stored next to each other, so walking the tree touches few cache lines and the
+// whole tree is a single allocation; a player without moves gets a single pass child
+class GameTree
+{
+public:
+    GameTree(char board[8][8], int depth, char player);
+
+    ~GameTree(){
+        std::free(nodes_);
+    }
+
+    GameTree(const GameTree &) = delete;
+    GameTree & operator=(const GameTree &) = delete;
+
+    Node & root(){ return nodes_[0]; }
+    Node & child(const Node & node, int i){ return nodes_[node.first_child + i]; }
+    std::size_t size() const { return size_; }
+
+private:
+    // add the subtree below nodes[index], the children of a node are appended together before any grandchild
+    static void build(std::vector<Node> & nodes, std::size_t index, int depth, char player);
+
+    Node * nodes_;
+    std::size_t size_;
+};
+
+const int MAX_LINE = 64; // longest principal variation kept
+
+// moves expected to be played from a position on (squares, NO_MOVE for a pass), filled in by the search
+struct Line
+{
+    uint8_t moves[MAX_LINE];
+    int length = 0;
+
+    // this line becomes move followed by rest
+    void set(uint8_t move, const Line & rest){
+        moves[0] = move;
+        length = std::min(rest.length + 1, MAX_LINE);
+        std::memcpy(moves + 1, rest.moves, (length - 1) * sizeof(uint8_t));
+    }
+};
+
+// static evaluation of a tree node
+int heuristic(const Node & node, const EvalWeights & weights);
+
+// minimax over a prebuilt game tree without alpha-beta pruning (alphabeta=0), every node gets its value; the
+// alpha-beta engine is search(), which works on the board directly
+int minimax(GameTree & tree, Node & position, int depth, bool maximizing_player, Line & pv,
+            const EvalWeights & weights = DEFAULT_WEIGHTS);
+
+// kind of value stored in the transposition table
+const int TT_EXACT = 0; // the exact minimax value
+
+const int TT_LOWER = 1; // the value is at least score (the search failed high)
+
+const int TT_UPPER = 2; // the value is at most score (the search failed low)
+
+// a decoded transposition table entry
+struct TTEntry
+{
+    int score;
+    int depth;
+    int bound; // TT_EXACT, TT_LOWER or TT_UPPER
+    int move; // best move found (row * 8 + col), -1 if none
+};
+
+// hash table of search results keyed by hashPosition(), shared by searches (and threads) to avoid searching a
+// position twice; entries are stored as (key ^ data, data) so a torn write between threads is detected on probe
+// the table is meant to be kept from one move to the next: its owner bumps the generation once per move of the
+// game (search() and scoreMoves() leave that to their callers), and entries left over from earlier moves are the
+// first to be replaced, so the next search starts warm without the table filling up with positions that can no
+// longer occur
+class TranspositionTable
+{
+public:
+    explicit TranspositionTable(std::size_t megabytes){
+        std::size_t slots = BUCKET_SIZE;
+        while(slots * 2 * sizeof(Slot) <= megabytes * 1024 * 1024)
+            slots *= 2;
+        slots_.reset(new Slot[slots]);
+        mask_ = slots - 1;
+        clear();
+    }
+
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable & operator=(const TranspositionTable &) = delete;
+
+    // returns true and fills entry if key is in the table
+    bool probe(uint64_t key, TTEntry & entry) const {
+        const Slot * bucket = &slots_[key & mask_ & ~std::size_t(BUCKET_SIZE - 1)];
+        for(int i = 0; i < BUCKET_SIZE; ++i){
+            uint64_t data = bucket[i].data.load(std::memory_order_relaxed);
+            if((bucket[i].check.load(std::memory_order_relaxed) ^ data) != key || data == 0)
+                continue;
+
+            entry.score = static_cast<int32_t>(data & 0xffffffff);
+            entry.depth = static_cast<int>((data >> 32) & 0xff);
+            entry.bound = static_cast<int>((data >> 40) & 0x3);
+            int move = static_cast<int>((data >> 42) & 0x7f);
+            entry.move = (move < 64) ? move : -1;
+            return true;
+        }
+        return false;
+    }
+
+    // keep the deeper result when the same position is already stored by this search, otherwise replace the
+    // entry of the bucket that is least worth keeping: empty first, then old and shallow
+    void store(uint64_t key, int score, int depth, int bound, int move){
+        Slot * bucket = &slots_[key & mask_ & ~std::size_t(BUCKET_SIZE - 1)];
+        unsigned generation = generation_.load(std::memory_order_relaxed);
+        Slot * victim = NULL;
+        int victim_worth = 0;
+        for(int i = 0; i < BUCKET_SIZE; ++i){
+            uint64_t old_data = bucket[i].data.load(std::memory_order_relaxed);
+            if((bucket[i].check.load(std::memory_order_relaxed) ^ old_data) == key && old_data != 0){
+                if(entryGeneration(old_data) == generation && static_cast<int>((old_data >> 32) & 0xff) > depth)
+                    return;
+                victim = &bucket[i];
+                break;
+            }
+
+            // an entry loses the worth of a few plies of depth for every search it has not been used in
+            int age = static_cast<int>((generation - entryGeneration(old_data)) & GENERATION_MASK);
+            int worth = (old_data == 0) ? -1000 : static_cast<int>((old_data >> 32) & 0xff) - 8 * age;
+            if(victim == NULL || worth < victim_worth){
+                victim = &bucket[i];
+                victim_worth = worth;
+            }
+        }
+
+        uint64_t data = static_cast<uint32_t>(score)
+                        | (static_cast<uint64_t>(depth & 0xff) << 32)
+                        | (static_cast<uint64_t>(bound) << 40)
+                        | (static_cast<uint64_t>((move >= 0) ? move : 64) << 42)
+                        | (uint64_t(1) << 49) // never 0, so an empty slot can't match
+                        | (static_cast<uint64_t>(generation) << 50);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
+    }
+
+    // called once per move of the game, entries stored before are aged by one; the 6-bit generation wraps after 64
+    // moves, so calling it for every search of a move would soon make the oldest entries look current again
+    void newSearch(){
+        unsigned generation = generation_.load(std::memory_order_relaxed);
+        generation_.store((generation + 1) & GENERATION_MASK, std::memory_order_relaxed);
+    }
+
+    void clear(){
+        for(std::size_t i = 0; i <= mask_; ++i){
+            slots_[i].check.store(0, std::memory_order_relaxed);
+            slots_[i].data.store(0, std::memory_order_relaxed);
+        }
+        generation_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static const int BUCKET_SIZE = 4; // slots a position may occupy (64 bytes)
+    static const unsigned GENERATION_MASK = 0x3f;
+
+    struct Slot
+    {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data; // score (32 bits), depth (8), bound (2), move (7), 1, generation (6)
+    };
+
+    static unsigned entryGeneration(uint64_t data){
+        return static_cast<unsigned>(data >> 50) & GENERATION_MASK;
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_;
+    std::atomic<unsigned> generation_{0};
+};
+
+// everything that distinguishes one AI from another, so that two configurations can be played against each other
+struct EngineConfig
+{
+    std::string name = "default";
+    int depth = MINIMAX_DEPTH; // depth of the game tree search
+    int time_ms = 0; // time limit per move in milliseconds (0 for none), only used with alpha-beta
+    bool alpha_beta = true; // set to false to search a full game tree with the simplified minimax (no pruning)
+    EvalWeights weights; // weights handed to heuristic()
+    const OpeningBook * book = NULL; // consulted before searching, NULL to always search
+    TranspositionTable * tt = NULL; // remembers search results across searches, NULL to search without one
+    int tt_megabytes = 0; // size of a table kept for the length of one game by tournaments and self-play, 0 for none
+    int aspiration = ASPIRATION_WINDOW; // see ASPIRATION_WINDOW, only used with alpha-beta
+    bool mtdf = false; // find the value of each iteration with MTD(f) instead of aspiration windows, wants a tt
+    double probcut = PROBCUT_CONFIDENCE; // multi-probcut confidence in standard deviations, 0 for a full-width search
+    int endgame = ENDGAME_EMPTIES; // see ENDGAME_EMPTIES, 0 to never solve
+    int etc_depth = ETC_DEPTH; // see ETC_DEPTH, only used with a tt
+};
+
+// limits for one search, whichever is reached first ends it
+struct SearchLimits
+{
+    int depth = MINIMAX_DEPTH; // deepest iteration of the iterative deepening
+    int time_ms = 0; // time limit in milliseconds, 0 for none
+};
+
+// outcome of a search, scores follow heuristic(): positive is good for black
+struct SearchResult
+{
+    uint8_t move = NO_MOVE; // best move (row * 8 + col), NO_MOVE when the player has no legal move
+    Line pv; // expected line starting with move
+    int score = 0; // value of the best move found by the deepest completed iteration
+    int depth = 0; // deepest completed iteration
+    long long nodes = 0; // positions visited
+    long long etc_cutoffs = 0; // nodes cut by enhanced transposition cutoffs
+    double seconds = 0.0; // time spent searching
+};
+
+// a root move together with its value, used when every root move is scored (hints)
+struct MoveScore
+{
+    uint8_t move; // row * 8 + col
+    int score;
+    bool exact = true; // false when the move is known to be outside the best moves asked for, score is then a bound
+};
+
+// linear model predicting the value of a deep search from a shallow one: deep = a * shallow + b, with sigma the
+// standard deviation of the prediction error; values are from the point of view of the player to move (so b is
+// that player's advantage of searching deeper), a = 0 means there is no model
+struct ProbCutModel
+{
+    double a;
+    double b;
+    double sigma;
+};
+
+const int PROBCUT_MIN_DEPTH = 3; // shallowest search that is worth cutting
+
+const int PROBCUT_STAGES = 4; // game stages with their own models, by number of discs (see probCutStage())
+
+const int PROBCUT_DEPTHS = 9; // models exist for depths below this, deeper searches use the deepest of the same parity
+
+// depth of the shallow search that predicts a search of depth, of the same parity because the evaluation
+// swings between odd and even depths
+int probCutDepth(int depth);
+
+// index of the models of board's game stage, see PROBCUT_STAGES
+int probCutStage(const char board[8][8]);
+
+// line starting with move (which player plays in board) that follows the best moves stored in tt, at most length
+// moves long
+Line tablePrincipalVariation(const TranspositionTable & tt, char board[8][8], char player, uint8_t move, int length);
+
+// iterative deepening driver: searches depth 1, 2, ... until limits.depth, the time limit or a stop request,
+// on_iteration (if set) is called with the result of every completed iteration
+// the move of the deepest completed iteration is returned, so a stopped search still answers with a move
+// from config.endgame empty squares on, a depth limit reaching the end of the game makes it an exact solve instead
+// (a single iteration whose depth is the number of empty squares), shorter limits keep the depth-limited search
+SearchResult search(char board[8][8], char player, const SearchLimits & limits, const EngineConfig & config,
+                    const std::atomic<bool> & stop, const std::function<void(const SearchResult &)> & on_iteration = nullptr);
+
+// like search(), but every root move gets a value, sorted best first (multi-pv): the multi_pv best moves (all of
+// them for 0) get exact values, every other move is only searched far enough to prove that it is no better than
+// those and is marked as not exact; the scores are those of the deepest completed iteration, all moves are searched
+// to the same depth and share the transposition table
+std::vector<MoveScore> scoreMoves(char board[8][8], char player, const SearchLimits & limits, const EngineConfig & config,
+                                  const std::atomic<bool> & stop, int multi_pv = 0);
+
+// print the legal moves of player best first, each with its score (see scoreMoves()) from the player's point of
+// view; moves without an exact score are only known to be no better than the given value
+void printLegalMoves(char player, const std::vector<MoveScore> & scores);
+
+// limits of a search for the engine's own move: config.depth and config.time_ms, with the depth raised to the end of
+// the game from config.endgame empty squares on so that the position is solved
+SearchLimits engineLimits(char board[8][8], const EngineConfig & config);
+
+// play the book move if there is one, otherwise search for the passed-in player and return the move (row * 8 + col)
+// leading to the optimal value, NO_MOVE if the player has to pass; the search ages config.tt as a new move
+uint8_t chooseMove(char board[8][8], char player, const EngineConfig & config);
+
+// thinks on the opponent's time: while the opponent decides, the engine searches its reply to the opponent's
+// expected move and then to every other move, so that the reply is ready (and the transposition table warm)
+// by the time the move arrives
+class Ponderer
+{
+public:
+    Ponderer() : stop_(false) {}
+    Ponderer(const Ponderer &) = delete;
+    Ponderer & operator=(const Ponderer &) = delete;
+    ~Ponderer(){ stop(); }
+
+    // start pondering the position in which opponent is about to move, config is the engine's own configuration
+    // (its table is aged once for the opponent's move)
+    void start(char board[8][8], char opponent, const EngineConfig & config);
+
+    // stop pondering (returns once the background search has ended)
+    void stop(){
+        stop_ = true;
+        if(thread_.joinable())
+            thread_.join();
+    }
+
+    // the move prepared for the engine in this position, NO_MOVE if pondering didn't get to it
+    uint8_t readyMove(char board[8][8]);
+
+private:
+    struct ReadyMove
+    {
+        char board[8][8]; // position after the opponent's move
+        uint8_t move; // the engine's full-depth answer to it
+    };
+
+    std::atomic<bool> stop_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<ReadyMove> ready_;
+};
+
+// parse an engine description such as "name=deep,depth=6,corner=20" into an EngineConfig
+// recognized keys: name, depth, time (ms per move), alphabeta (0/1), mobility, disc, corner,
+// tt (megabytes of transposition table kept across the moves of a game), aspiration (window half-width, 0 for none),
+// mtdf (0/1, MTD(f) instead of aspiration windows), probcut (confidence, 0 for a full-width search),
+// endgame (empty squares from which positions are solved exactly, 0-60, 0 for never), etc (shallowest depth using
+// enhanced transposition cutoffs, 0 for none)
+EngineConfig parseEngineConfig(const std::string & spec);
+
+#endif // OTHELLO_SEARCH_H
@@ -13,461 +13,1762 @@
  * A simple heursitic which takes into account discs belonging to each player,
  * corner occupation, and number of available moves is used by the AI to give
  * value to the board configurations it considers.
+ *
+ * The engine itself lives in the othello library (include/othello, src), this
+ * file is the console game and the command line tools built on top of it.
 */
 
+#include "othello/board.h"
+#include "othello/eval.h"
+#include "othello/files.h"
+#include "othello/history.h"
+#include "othello/search.h"
+
 #include <iostream>
 #include <stdexcept>
 #include <array>
 #include <vector>
 #include <regex>
-
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <cstdint>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <sstream>
+#include <deque>
+#include <condition_variable>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
 
 const bool PLAY_AI = true; // set to true if you want to play the AI
-const int MINIMAX_DEPTH = 5; // depth of the game tree search
-const bool DEBUG_MODE = false;
+const bool PONDER = true; // set to true to let the AI think while it is the human's turn
+const bool COACH = false; // set to true to show the AI's score of every legal move of the human
+const int SERVER_MAX_TIME_MS = 10000; // default --max-time of the server, longest a search may hold a search thread
+const char * const OPENING_BOOK_PATH = "book.bin"; // opening book used by the AI when the file exists (see "othello book")
 
-// flips appropriate pieces after a disc is placed down (called after verifying the move isFlippable)
-void flip(char (&board)[8][8], int row, int col, char player){
-    // declare a list of positions of discs that will be flipped
-    // e.g. {{0,1}, {0,2}} means disc at location board[0][1] & board[0][2] will be flipped
-    std::vector<std::vector<int>> discs_to_flip;
+// settings for an engine-vs-engine match (see runTournament)
+struct TournamentConfig
+{
+    EngineConfig engine_a;
+    EngineConfig engine_b;
+    int max_pairs = 1000; // give up after this many game pairs if the SPRT has not concluded
+    int opening_plies = 6; // random moves played from the initial board to create each opening
+    unsigned seed = 1; // seeds the opening generator, the same seed always yields the same openings
+    int threads = 1; // number of games played concurrently
+    double elo0 = 0.0; // SPRT null hypothesis: engine_a is elo0 points stronger than engine_b
+    double elo1 = 10.0; // SPRT alternative hypothesis: engine_a is elo1 points stronger than engine_b
+    double alpha = 0.05; // probability of accepting H1 when H0 is true
+    double beta = 0.05; // probability of accepting H0 when H1 is true
+};
 
-    char otherPlayer = (player == 'b') ? 'w' : 'b';
+// running totals of a tournament, all results are from engine_a's point of view
+struct TournamentStats
+{
+    int pentanomial[5] = {0, 0, 0, 0, 0}; // number of game pairs scoring 0, 0.5, 1, 1.5 and 2 points
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    long long moves[2] = {0, 0}; // moves made by engine_a / engine_b
+    double seconds[2] = {0.0, 0.0}; // time spent choosing those moves by engine_a / engine_b
+};
 
-    // use deltas to find all 8 surrounding positions
-    int surroundingPosDeltas[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, // 3 positions above
-                                      {0, -1}, {0, 1}, // 2 positions on same row
-                                      {1, -1}, {1, 0}, {1, 1}}; // 3 positions below
+// play a pseudo-random opening from the initial board, deterministic for a given seed
+void generateOpening(char (&board)[8][8], char & player, int plies, std::seed_seq & seed){
+    std::mt19937 rng(seed);
+    initializeBoard(board);
+    player = 'b';
+
+    for(int ply = 0; ply < plies && !isGameOver(board); ++ply){
+        MoveList move_list = calculateLegalMoves(board, player);
+        if(move_list.empty()){ // pass
+            player = (player == 'w') ? 'b' : 'w';
+            continue;
+        }
+
+        std::uniform_int_distribution<std::size_t> pick(0, move_list.size() - 1);
+        int square = move_list.squares[pick(rng)];
+        makeMove(board, square / 8, square % 8, player);
+        player = (player == 'w') ? 'b' : 'w';
+    }
+}
+
+// copy of config for playing one game: an engine asking for tt_megabytes (and not already sharing a table) gets
+// a fresh table, kept in table, that carries what it learned on one move over to its next
+EngineConfig gameEngine(const EngineConfig & config, std::unique_ptr<TranspositionTable> & table){
+    EngineConfig engine = config;
+    if(engine.tt == NULL && engine.tt_megabytes > 0){
+        table.reset(new TranspositionTable(engine.tt_megabytes));
+        engine.tt = table.get();
+    }
+    return engine;
+}
 
-    // for every delta representing a neighboring position...
-    for(auto deltas : surroundingPosDeltas){
-        //std::cout << "deltas: [" << deltas[0] << ", " << deltas[1] << "]" << '\n';
+// play out a game from the passed-in position, returns black's disc count minus white's
+// time spent and moves made by each engine are added to seconds[] / moves[] (index 0 = black, 1 = white)
+int playGame(const char (&opening)[8][8], char player, const EngineConfig & black, const EngineConfig & white,
+             double (&seconds)[2], long long (&moves)[2]){
+    char board[8][8];
+    std::memcpy(board, opening, 8 * 8 * sizeof(char));
 
-        // save what row/col currently on
-        int curr_row = row + deltas[0];
-        int curr_col = col + deltas[1];
+    std::unique_ptr<TranspositionTable> tables[2];
+    const EngineConfig engines[2] = {gameEngine(black, tables[0]), gameEngine(white, tables[1])};
 
-        // ignore if this goes off of the board
-        if(curr_row > 7 || curr_row < 0 || curr_col > 7 || curr_col < 0)
+    while(!isGameOver(board)){
+        if(calculateLegalMoves(board, player).empty()){ // pass
+            player = (player == 'w') ? 'b' : 'w';
             continue;
+        }
 
+        int side = (player == 'b') ? 0 : 1;
+        auto start = std::chrono::steady_clock::now();
+        uint8_t move = chooseMove(board, player, engines[side]);
+        seconds[side] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        moves[side] += 1;
 
-        // save character in this position
-        char char_in_pos = board[curr_row][curr_col];
+        makeMove(board, move / 8, move % 8, player);
+        player = (player == 'w') ? 'b' : 'w';
+    }
 
-        // use this variable to save whether or not a line of pieces should be flipped
-        bool flip_this_direction = false;
+    return getScore(board, 'b') - getScore(board, 'w');
+}
 
-        // if the character in this delta position is the opponent's piece...
-        if(char_in_pos == otherPlayer){
-            //std::cout << "Found other player at location: [" << curr_row << ", " << curr_col << "], " << char_in_pos << '\n';
+// expected score of the stronger side for an elo difference (logistic model)
+double eloToScore(double elo){
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
 
-            // continue in this delta position until the next character is no longer the opponent's or you go off the board
-            while(char_in_pos == otherPlayer){
-                curr_row += deltas[0];
-                curr_col += deltas[1];
+// inverse of eloToScore, clamped so a perfect score does not give an infinite difference
+double scoreToElo(double score){
+    score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    return 400.0 * std::log10(score / (1.0 - score));
+}
 
-                // check to see if new position is off board
-                if(curr_row > 7 || curr_row < 0 || curr_col > 7 || curr_col < 0)
-                    break;
+// mean and variance of the per-game score over all game pairs (pair scores are normalized to [0, 1])
+void pentanomialMoments(const int (&pentanomial)[5], double & mean, double & variance){
+    int pairs = 0;
+    mean = 0.0;
+    for(int i = 0; i < 5; ++i){
+        pairs += pentanomial[i];
+        mean += pentanomial[i] * (i / 4.0);
+    }
 
-                // save the character
-                char_in_pos = board[curr_row][curr_col];
-            }
+    variance = 0.0;
+    if(pairs == 0)
+        return;
 
-            // if the player's piece is found after traversing over the opponent's piece(s), we know we will be flipping
-            if(char_in_pos == player)
-                flip_this_direction = true;
-
-            // if we found out we should be flipping...
-            if(flip_this_direction){
-                // save current position
-                curr_row = row + deltas[0];
-                curr_col = col + deltas[1];
-                char_in_pos = board[curr_row][curr_col];
-
-                // traverse over the opponent's pieces, while saving the positions to the big list to be flipped later
-                while(char_in_pos == otherPlayer){
-                    //std::cout << "flipping [" << curr_row << ", " << curr_col << "]\n";
-                    std::vector<int> disc = {curr_row, curr_col};
-                    discs_to_flip.push_back(disc);
-                    curr_row += deltas[0];
-                    curr_col += deltas[1];
-
-                    // save next character
-                    char_in_pos = board[curr_row][curr_col];
-                }
+    mean /= pairs;
+    for(int i = 0; i < 5; ++i)
+        variance += pentanomial[i] * (i / 4.0 - mean) * (i / 4.0 - mean);
+    variance /= pairs;
+}
+
+// log-likelihood ratio of H1 (elo1) against H0 (elo0) for the observed game pairs,
+// uses the normal approximation of the generalized SPRT so that paired openings can be scored as pentanomial outcomes
+double sprtLLR(const int (&pentanomial)[5], double elo0, double elo1){
+    double mean, variance;
+    pentanomialMoments(pentanomial, mean, variance);
+    if(variance <= 0.0) // not enough information yet (e.g. every pair ended the same way)
+        return 0.0;
+
+    int pairs = 0;
+    for(int count : pentanomial)
+        pairs += count;
+
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return pairs * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+}
 
+// pit engine_a against engine_b over paired openings (each opening is played once with either engine as black),
+// playing config.threads games at once and stopping as soon as the SPRT accepts either hypothesis
+// returns 1 if H1 was accepted (engine_a is stronger), -1 if H0 was accepted, and 0 if the test was inconclusive
+int runTournament(const TournamentConfig & config){
+    const double lower_bound = std::log(config.beta / (1.0 - config.alpha));
+    const double upper_bound = std::log((1.0 - config.beta) / config.alpha);
+
+    TournamentStats stats;
+    std::mutex stats_mutex;
+    std::atomic<int> next_pair(0);
+    std::atomic<bool> finished(false);
+    int pairs_done = 0;
+    double llr = 0.0;
+
+    auto worker = [&](){
+        while(!finished){
+            int pair = next_pair++;
+            if(pair >= config.max_pairs)
+                return;
+
+            char opening[8][8];
+            char player;
+            std::seed_seq seed{config.seed, static_cast<unsigned>(pair)};
+            generateOpening(opening, player, config.opening_plies, seed);
+
+            // first game: engine_a plays black, second game: engine_a plays white
+            double seconds_first[2] = {0.0, 0.0}, seconds_second[2] = {0.0, 0.0};
+            long long moves_first[2] = {0, 0}, moves_second[2] = {0, 0};
+            int first = playGame(opening, player, config.engine_a, config.engine_b, seconds_first, moves_first);
+            int second = -playGame(opening, player, config.engine_b, config.engine_a, seconds_second, moves_second);
+
+            // engine_a's points over the pair in half points (0 = lost both, 4 = won both)
+            int half_points = 0;
+            for(int result : {first, second})
+                half_points += (result > 0) ? 2 : (result == 0) ? 1 : 0;
+
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            if(finished) // the test concluded while this pair was being played
+                return;
+
+            stats.pentanomial[half_points] += 1;
+            for(int result : {first, second}){
+                if(result > 0)
+                    stats.wins += 1;
+                else if(result == 0)
+                    stats.draws += 1;
+                else
+                    stats.losses += 1;
             }
+            stats.seconds[0] += seconds_first[0] + seconds_second[1];
+            stats.seconds[1] += seconds_first[1] + seconds_second[0];
+            stats.moves[0] += moves_first[0] + moves_second[1];
+            stats.moves[1] += moves_first[1] + moves_second[0];
+
+            pairs_done += 1;
+            llr = sprtLLR(stats.pentanomial, config.elo0, config.elo1);
+            std::cout << "Pairs: " << pairs_done << "  W/D/L: " << stats.wins << "/" << stats.draws << "/" << stats.losses
+                      << "  LLR: " << llr << " [" << lower_bound << ", " << upper_bound << "]\n";
+
+            if(llr <= lower_bound || llr >= upper_bound)
+                finished = true;
         }
+    };
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < std::max(config.threads, 1); ++i)
+        workers.emplace_back(worker);
+    for(auto & t : workers)
+        t.join();
+
+    double mean, variance;
+    pentanomialMoments(stats.pentanomial, mean, variance);
+    double margin = (pairs_done > 0) ? 1.96 * std::sqrt(variance / pairs_done) : 0.0;
+
+    std::cout << "\n" << config.engine_a.name << " vs " << config.engine_b.name << " after " << pairs_done << " pairs ("
+              << (stats.wins + stats.draws + stats.losses) << " games)\n";
+    std::cout << "Score: " << stats.wins << " wins, " << stats.draws << " draws, " << stats.losses << " losses\n";
+    std::cout << "Elo difference: " << scoreToElo(mean)
+              << " [" << scoreToElo(mean - margin) << ", " << scoreToElo(mean + margin) << "] (95%)\n";
+    const EngineConfig * engines[2] = {&config.engine_a, &config.engine_b};
+    for(int i = 0; i < 2; ++i){
+        std::cout << engines[i]->name << ": " << stats.moves[i] << " moves, "
+                  << ((stats.moves[i] > 0) ? 1000.0 * stats.seconds[i] / stats.moves[i] : 0.0) << " ms/move\n";
     }
 
-    // after we've collecting the row/col of all discs to flipped, flip them to the current player's color/character
-    for(auto pos : discs_to_flip)
-        board[pos[0]][pos[1]] = player;
+    if(llr >= upper_bound){
+        std::cout << "SPRT: H1 accepted (" << config.engine_a.name << " is stronger)\n";
+        return 1;
+    }
+    if(llr <= lower_bound){
+        std::cout << "SPRT: H0 accepted (" << config.engine_a.name << " is not elo1 stronger)\n";
+        return -1;
+    }
+    std::cout << "SPRT: inconclusive, raise the number of pairs\n";
+    return 0;
 }
 
-// a move "isFlippable" if it causes pieces to flip
-bool isFlippable(char board[8][8], int row, int col, char player) {
-    char otherPlayer = (player == 'b') ? 'w' : 'b';
-
-    // Check all 8 surround positions
-    int surroundingPosDeltas[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, // 3 positions above
-                                      {0, -1}, {0, 1}, // 2 positions on same row
-                                      {1, -1}, {1, 0}, {1, 1}}; // 3 positions below
-
-    // for every delta of the surrounding positions
-    for(auto deltas : surroundingPosDeltas){
+// command line front-end for runTournament:
+// othello tournament --engine-a <spec> --engine-b <spec> [--pairs N] [--plies N] [--threads N] [--seed N]
+//                    [--elo0 X] [--elo1 X] [--alpha X] [--beta X] [--book-a <file>] [--book-b <file>]
+int tournamentCommand(int argc, char * argv[]){
+    TournamentConfig config;
+    OpeningBook books[2];
+    std::string book_paths[2];
+    config.engine_a.name = "A";
+    config.engine_b.name = "B";
+    config.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    try{
+        for(int i = 2; i < argc; ++i){
+            std::string arg = argv[i];
+            if(i + 1 >= argc)
+                throw std::invalid_argument{"missing value for " + arg};
+            std::string value = argv[++i];
+
+            if(arg == "--engine-a"){
+                config.engine_a = parseEngineConfig(value);
+                if(value.find("name=") == std::string::npos)
+                    config.engine_a.name = "A";
+            } else if(arg == "--engine-b"){
+                config.engine_b = parseEngineConfig(value);
+                if(value.find("name=") == std::string::npos)
+                    config.engine_b.name = "B";
+            }
+            else if(arg == "--pairs")
+                config.max_pairs = std::stoi(value);
+            else if(arg == "--plies")
+                config.opening_plies = std::stoi(value);
+            else if(arg == "--threads")
+                config.threads = std::stoi(value);
+            else if(arg == "--seed")
+                config.seed = static_cast<unsigned>(std::stoul(value));
+            else if(arg == "--elo0")
+                config.elo0 = std::stod(value);
+            else if(arg == "--elo1")
+                config.elo1 = std::stod(value);
+            else if(arg == "--alpha")
+                config.alpha = std::stod(value);
+            else if(arg == "--beta")
+                config.beta = std::stod(value);
+            else if(arg == "--book-a")
+                book_paths[0] = value;
+            else if(arg == "--book-b")
+                book_paths[1] = value;
+            else
+                throw std::invalid_argument{"unknown option " + arg};
+        }
+    } catch(std::logic_error & e){ // std::invalid_argument and std::out_of_range from the parsers above
+        std::cout << "tournament: " << e.what() << '\n';
+        return 1;
+    }
 
-        // skip if the position is off of game board
-        if(row+deltas[0] > 7 || row+deltas[0] < 0 || col+deltas[1] > 7 || col+deltas[1] < 0){
+    EngineConfig * engines[2] = {&config.engine_a, &config.engine_b};
+    for(int i = 0; i < 2; ++i){
+        if(book_paths[i].empty())
             continue;
+        if(!books[i].open(book_paths[i])){
+            std::cout << "tournament: could not open book " << book_paths[i] << '\n';
+            return 1;
         }
+        engines[i]->book = &books[i];
+    }
 
-        //std::cout << "deltas: [" << deltas[0] << ", " << deltas[1] << "]" << '\n';
-        char char_in_pos = board[row+deltas[0]][col+deltas[1]]; // grab the character in that spot
-
-        // if the character in this delta spot is the opponent's piece...
-        if(char_in_pos == otherPlayer){
-            // save spot's row and col #
-            int curr_row = row + deltas[0];
-            int curr_col = col + deltas[1];
+    runTournament(config);
+    return 0;
+}
 
-            //std::cout << "Found other player at location: [" << curr_row << ", " << curr_col << "], " << char_in_pos << '\n';
+// command line front-end for WthorReader, replays every game of the passed-in files and reports what was found;
+// with --transcripts the games are also printed as transcripts for "othello book build --input",
+// with --pack they are also written to a compact game file (see RecordFileWriter)
+// othello wthor [--transcripts] [--pack <out.games>] <file.wtb>...
+int wthorCommand(int argc, char * argv[]){
+    bool transcripts = false;
+    std::string pack_path;
+    std::vector<std::string> paths;
+    for(int i = 2; i < argc; ++i){
+        if(std::string(argv[i]) == "--transcripts")
+            transcripts = true;
+        else if(std::string(argv[i]) == "--pack" && i + 1 < argc)
+            pack_path = argv[++i];
+        else
+            paths.push_back(argv[i]);
+    }
 
-            //continue along this delta trajectory until you stop seeing the opponent's pieces
-            while(char_in_pos == otherPlayer){
-                curr_row += deltas[0];
-                curr_col += deltas[1];
+    if(paths.empty()){
+        std::cout << "usage: othello wthor [--transcripts] [--pack <out.games>] <file.wtb>...\n";
+        return 1;
+    }
 
-                // check to see if new position is off board
-                if(curr_row > 7 || curr_row < 0 || curr_col > 7 || curr_row < 0)
-                    break;
+    std::unique_ptr<RecordFileWriter> pack;
+    if(!pack_path.empty())
+        pack.reset(new RecordFileWriter(pack_path, GAME_FILE_MAGIC));
+    char initial_board[8][8];
+    initializeBoard(initial_board);
+    PackedPosition initial_position;
+    packPosition(initial_board, 'b', initial_position);
+    std::vector<uint8_t> packed_moves;
+
+    long long games = 0, positions = 0, illegal = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(const auto & path : paths){
+        WthorReader reader;
+        if(!reader.open(path)){
+            std::cerr << "wthor: could not read " << path << '\n';
+            return 1;
+        }
 
-                // save the next character
-                char_in_pos = board[curr_row][curr_col];
+        for(std::size_t i = 0; i < reader.size(); ++i){
+            WthorGame game = reader.game(i);
+            std::string transcript;
+            packed_moves.clear();
+            bool legal = replayWthorGame(game, [&](char (&)[8][8], char, int row, int col){
+                positions += 1;
+                if(transcripts)
+                    transcript += squareName(row, col);
+                packed_moves.push_back(static_cast<uint8_t>(row * 8 + col));
+            });
+
+            if(!legal){
+                illegal += 1;
+                continue;
             }
+            games += 1;
+            if(transcripts)
+                std::cout << transcript << '\n';
+            if(pack)
+                pack->writeGame(initial_position, packed_moves);
+        }
+    }
 
-            // if the player's piece is seen after one (+more) of the opponent's pieces, the original move is a flippable one
-            if(char_in_pos == player)
-                return true;
+    if(pack){
+        try{
+            pack->close();
+        } catch(std::runtime_error & e){
+            std::cerr << e.what() << '\n';
+            return 1;
         }
     }
 
-    // if no flippable spot is found after checking all surrounding positions, the original move is not a flippable one
-    return false;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Replayed " << games << " games (" << positions << " positions) in " << seconds << "s, "
+              << illegal << " games with illegal moves skipped\n";
+    return 0;
 }
 
-// set board[row][col] to player's piece, and flip appropriate pieces
-void makeMove(char (&board)[8][8], int row, int col, char player){
-    //std::cout << "Updating row: " << row << " col: " << col << '\n';
-    // set provided row/col position to the player's character piece
-    board[row][col] = player;
+// collects the positions of many games and turns them into an opening book:
+// for every position the move with the best average result is kept
+class BookBuilder
+{
+public:
+    explicit BookBuilder(int max_plies) : max_plies_(max_plies) {}
+
+    // replay a game (squares played from the initial board, passes are implied) and record its first max_plies
+    // positions, returns false without recording anything if a move is illegal
+    bool addGame(const std::vector<uint8_t> & moves){
+        char board[8][8];
+        std::vector<BookSample> samples;
+        if(!replay(moves, moves.size(), board, samples))
+            return false;
+
+        record(samples, getScore(board, 'b') - getScore(board, 'w'));
+        return true;
+    }
 
-    // flip discs from resulting move
-    flip(board, row, col, player);
-}
+    // same as above for games whose final result (black's discs minus white's) is already known, e.g. from a game
+    // database, only the moves that end up in the book are replayed
+    bool addGame(const std::vector<uint8_t> & moves, int black_margin){
+        char board[8][8];
+        std::vector<BookSample> samples;
+        if(!replay(moves, std::min(moves.size(), static_cast<std::size_t>(max_plies_)), board, samples))
+            return false;
+
+        record(samples, black_margin);
+        return true;
+    }
+
+    // write the book to path, positions reached by fewer than min_visits games are left out
+    // returns the number of positions written
+    std::size_t write(const std::string & path, uint32_t min_visits) const {
+        std::vector<BookEntry> entries;
+        for(const auto & position : positions_){
+            const BookMoveStats * best = NULL;
+            uint32_t visits = 0;
+            for(const auto & s : position.second){
+                visits += s.visits;
+                // compare average results without dividing: a/b > c/d  <=>  a*d > c*b
+                if(s.visits >= min_visits && (best == NULL || s.total * best->visits > best->total * s.visits))
+                    best = &s;
+            }
+            if(best == NULL)
+                continue;
 
-// used to algorithmically calculate legal moves belonging to passed-in player
-std::vector<std::vector<int>> calculateLegalMoves(char board[8][8], char player) {
+            BookEntry entry;
+            entry.hash = position.first;
+            entry.visits = visits;
+            entry.score = static_cast<int16_t>(std::lround(static_cast<double>(best->total) / best->visits));
+            entry.move = best->move;
+            entry.reserved = 0;
+            entries.push_back(entry);
+        }
 
-    // declare main move list
-    std::vector<std::vector<int>> move_list;
+        std::sort(entries.begin(), entries.end(), [](const BookEntry & a, const BookEntry & b){ return a.hash < b.hash; });
 
-    for(int i = 0; i < 8; ++i){
-        for(int j = 0; j < 8; ++j){
-            // first make sure the spot is empty
-            if(board[i][j] == '-'){
+        BookHeader header;
+        std::memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+        header.count = entries.size();
 
-                // check to see if placing a piece there will flip one (+more) of the opponent's pieces
-                if(isFlippable(board, i, j, player)){
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(BookEntry));
+        if(!out)
+            throw std::runtime_error{"BookBuilder::write(): could not write " + path};
 
-                    // if so, create a 2-element vector representative of the move and push it to the big move list
-                    std::vector<int> move = {i, j};
-                    move_list.push_back(move);
-                }
+        return entries.size();
+    }
+
+    long long games() const { return games_; }
+
+private:
+    // a position of a game in canonical form together with the move that was played there
+    struct BookSample
+    {
+        uint64_t hash;
+        uint8_t move;
+        char player;
+    };
+
+    // play the first count moves of a game, collecting the first max_plies positions into samples
+    bool replay(const std::vector<uint8_t> & moves, std::size_t count, char (&board)[8][8],
+                std::vector<BookSample> & samples) const {
+        initializeBoard(board);
+        char player = 'b';
+
+        for(std::size_t i = 0; i < count; ++i){
+            int row = moves[i] / 8, col = moves[i] % 8;
+            if(moves[i] >= 64 || !recordedMoveIsLegal(board, player, row, col))
+                return false;
+
+            // positions are recorded in canonical form so that symmetric variants are merged
+            if(static_cast<int>(samples.size()) < max_plies_){
+                int transform;
+                uint64_t hash = canonicalHash(board, player, transform);
+                uint8_t square = static_cast<uint8_t>(transformSquare(moves[i], transform));
+                samples.push_back(BookSample{hash, square, player});
+            }
+
+            makeMove(board, row, col, player);
+            player = (player == 'w') ? 'b' : 'w';
+        }
+        return true;
+    }
 
+    // add the samples of one game that ended with black_margin (black's discs minus white's) to the statistics
+    void record(const std::vector<BookSample> & samples, int black_margin){
+        for(const auto & sample : samples){
+            std::vector<BookMoveStats> & stats = positions_[sample.hash];
+            auto it = std::find_if(stats.begin(), stats.end(),
+                                   [&](const BookMoveStats & s){ return s.move == sample.move; });
+            if(it == stats.end()){
+                stats.push_back(BookMoveStats{sample.move, 0, 0});
+                it = stats.end() - 1;
             }
+            it->visits += 1;
+            it->total += (sample.player == 'b') ? black_margin : -black_margin;
         }
+
+        games_ += 1;
     }
 
-    return move_list;
+    struct BookMoveStats
+    {
+        uint8_t move;
+        uint32_t visits;
+        int64_t total; // sum of the final disc differences, from the point of view of the player making the move
+    };
+
+    int max_plies_;
+    long long games_ = 0;
+    std::unordered_map<uint64_t, std::vector<BookMoveStats>> positions_;
+};
+
+// play a game of the engine against itself, making a random move instead with probability random_rate during
+// the first random_plies plies so that the games cover a variety of openings; returns the squares played
+std::vector<uint8_t> selfPlayGame(const EngineConfig & config, std::mt19937 & rng, double random_rate, int random_plies){
+    char board[8][8];
+    initializeBoard(board);
+    char player = 'b';
+    std::vector<uint8_t> moves;
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+    std::unique_ptr<TranspositionTable> table;
+    const EngineConfig engine = gameEngine(config, table);
+
+    while(!isGameOver(board)){
+        MoveList move_list = calculateLegalMoves(board, player);
+        if(move_list.empty()){ // pass
+            player = (player == 'w') ? 'b' : 'w';
+            continue;
+        }
+
+        uint8_t square;
+        if(static_cast<int>(moves.size()) < random_plies && coin(rng) < random_rate){
+            std::uniform_int_distribution<std::size_t> pick(0, move_list.size() - 1);
+            square = move_list.squares[pick(rng)];
+        } else {
+            square = chooseMove(board, player, engine);
+        }
+
+        makeMove(board, square / 8, square % 8, player);
+        moves.push_back(square);
+        player = (player == 'w') ? 'b' : 'w';
+    }
 
+    return moves;
 }
 
-// for a given board configuration, determine if a move is legal (searches through a previously generated movelist)
-bool isLegalMove(char board[8][8], std::vector<std::vector<int>> move_list, int row, int col, char player) {
-    std::vector<int> proposedMove = {row, col};
-//    for (int i : proposedMove) {
-//        std::cout << i << ' ';
-//    }
+// command line front-end for BookBuilder:
+// othello book build --output <file> [--input <transcripts.txt>]... [--wthor <file.wtb>]... [--games N] [--plies N] [--min-visits N]
+//                    [--engine <spec>] [--random X] [--random-plies N] [--threads N] [--seed N]
+int bookCommand(int argc, char * argv[]){
+    std::string output;
+    std::vector<std::string> inputs;
+    std::vector<std::string> wthor_inputs;
+    int games = 0;
+    int plies = 20;
+    uint32_t min_visits = 1;
+    EngineConfig engine;
+    double random_rate = 0.25;
+    int random_plies = 20;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned seed = 1;
+
+    try{
+        if(argc < 3 || std::string(argv[2]) != "build")
+            throw std::invalid_argument{"usage: othello book build --output <file> [options]"};
+
+        for(int i = 3; i < argc; ++i){
+            std::string arg = argv[i];
+            if(i + 1 >= argc)
+                throw std::invalid_argument{"missing value for " + arg};
+            std::string value = argv[++i];
+
+            if(arg == "--output")
+                output = value;
+            else if(arg == "--input")
+                inputs.push_back(value);
+            else if(arg == "--wthor")
+                wthor_inputs.push_back(value);
+            else if(arg == "--games")
+                games = std::stoi(value);
+            else if(arg == "--plies")
+                plies = std::stoi(value);
+            else if(arg == "--min-visits")
+                min_visits = static_cast<uint32_t>(std::stoul(value));
+            else if(arg == "--engine")
+                engine = parseEngineConfig(value);
+            else if(arg == "--random")
+                random_rate = std::stod(value);
+            else if(arg == "--random-plies")
+                random_plies = std::stoi(value);
+            else if(arg == "--threads")
+                threads = std::stoi(value);
+            else if(arg == "--seed")
+                seed = static_cast<unsigned>(std::stoul(value));
+            else
+                throw std::invalid_argument{"unknown option " + arg};
+        }
 
-    //This error should NOT occur, as the regex pattern validates the user's input
-    if(row > 7 || row < 0 || col > 7 || col < 0)
-        throw std::range_error{"isLegalMove()"};
+        if(output.empty())
+            throw std::invalid_argument{"--output is required"};
+        if(inputs.empty() && wthor_inputs.empty() && games <= 0)
+            throw std::invalid_argument{"nothing to build from, pass --input, --wthor and/or --games"};
+    } catch(std::logic_error & e){
+        std::cout << "book: " << e.what() << '\n';
+        return 1;
+    }
 
-    // Make sure position is empty
-    if(board[row][col] != '-'){
-        return false;
+    BookBuilder builder(plies);
+
+    // database games, one transcript per line ('#' starts a comment line)
+    for(const auto & path : inputs){
+        std::ifstream in(path);
+        if(!in){
+            std::cout << "book: could not open " << path << '\n';
+            return 1;
+        }
+
+        long long skipped = 0;
+        std::string line;
+        std::vector<uint8_t> moves;
+        while(std::getline(in, line)){
+            if(line.empty() || line[0] == '#')
+                continue;
+            if(!parseTranscript(line, moves) || !builder.addGame(moves))
+                skipped += 1;
+        }
+        if(skipped > 0)
+            std::cout << "book: skipped " << skipped << " malformed or illegal games in " << path << '\n';
     }
 
-    if (std::find(move_list.begin(), move_list.end(), proposedMove) != move_list.end()){
-        return true;
+    // WTHOR database games, the recorded final score spares replaying the moves beyond the book's depth
+    for(const auto & path : wthor_inputs){
+        WthorReader reader;
+        if(!reader.open(path)){
+            std::cout << "book: could not read " << path << '\n';
+            return 1;
+        }
+
+        long long skipped = 0;
+        std::vector<uint8_t> moves;
+        for(std::size_t i = 0; i < reader.size(); ++i){
+            WthorGame game = reader.game(i);
+            if(!wthorMoves(game, moves) || !builder.addGame(moves, 2 * game.black_score - 64))
+                skipped += 1;
+        }
+        if(skipped > 0)
+            std::cout << "book: skipped " << skipped << " illegal games in " << path << '\n';
     }
 
-    return false;
+    // self-play games, played concurrently
+    std::mutex builder_mutex;
+    std::atomic<int> next_game(0);
+    auto worker = [&](){
+        for(int game = next_game++; game < games; game = next_game++){
+            std::seed_seq game_seed{seed, static_cast<unsigned>(game)};
+            std::mt19937 rng(game_seed);
+            std::vector<uint8_t> moves = selfPlayGame(engine, rng, random_rate, random_plies);
+
+            std::lock_guard<std::mutex> lock(builder_mutex);
+            builder.addGame(moves);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < std::max(threads, 1); ++i)
+        workers.emplace_back(worker);
+    for(auto & t : workers)
+        t.join();
+
+    try{
+        std::size_t written = builder.write(output, min_visits);
+        std::cout << "Wrote " << written << " positions from " << builder.games() << " games to " << output << '\n';
+    } catch(std::runtime_error & e){
+        std::cout << e.what() << '\n';
+        return 1;
+    }
+    return 0;
 }
 
-// return a list of all the moves available to black
-std::vector<std::vector<int>> getBlackLegalMoves(char board[8][8]) {
-    return calculateLegalMoves(board, 'b');
-}
+// least squares fit of deep = a * shallow + b, see ProbCutModel
+struct ProbCutFit
+{
+    double n = 0, x = 0, y = 0, xx = 0, xy = 0, yy = 0;
+
+    void add(double shallow, double deep){
+        n += 1;
+        x += shallow;
+        y += deep;
+        xx += shallow * shallow;
+        xy += shallow * deep;
+        yy += deep * deep;
+    }
 
-// return a list of all the moves available to white
-std::vector<std::vector<int>> getWhiteLegalMoves(char board[8][8]) {
-    return calculateLegalMoves(board, 'w');
-}
+    ProbCutModel model() const {
+        ProbCutModel model = {0, 0, 0};
+        double det = n * xx - x * x;
+        if(n < 10 || det <= 0)
+            return model;
+
+        model.a = (n * xy - x * y) / det;
+        model.b = (y - model.a * x) / n;
+        double residual = yy - 2 * model.a * xy - 2 * model.b * y + model.a * model.a * xx
+                          + 2 * model.a * model.b * x + n * model.b * model.b;
+        model.sigma = std::sqrt(std::max(residual / n, 0.0));
+        return model;
+    }
+};
 
-// for the passed-in player, print all legal moves (displayed on board update)
-void printLegalMoves(char board[8][8], char player){
-    if(player == 'b'){
-        std::cout << "Black legal moves:\n";
-        auto v = getBlackLegalMoves(board);
-        for ( const auto &vec : v ) {
-            std::cout << "(" << vec[0]  << "," << vec[1] << ")  ";
+// fits the multi-probcut models: positions are sampled from self-play games (with random moves for variety) or
+// read from a position file, searched at every depth without probcut, and the deep values are regressed on the
+// shallow ones per stage and depth; prints the table to paste into PROBCUT_MODELS
+// othello probcut [--positions <count>] [--input <file.pos>] [--depth <plies>] [--threads <count>] [--seed <n>]
+int probCutCommand(int argc, char * argv[]){
+    int positions = 500;
+    std::string input;
+    int max_depth = 8;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned seed = 1;
+
+    try{
+        for(int i = 2; i < argc; ++i){
+            std::string arg = argv[i];
+            if(i + 1 >= argc)
+                throw std::invalid_argument{"missing value for " + arg};
+            std::string value = argv[++i];
+
+            if(arg == "--positions")
+                positions = std::stoi(value);
+            else if(arg == "--input")
+                input = value;
+            else if(arg == "--depth")
+                max_depth = std::stoi(value);
+            else if(arg == "--threads")
+                threads = std::stoi(value);
+            else if(arg == "--seed")
+                seed = static_cast<unsigned>(std::stoul(value));
+            else
+                throw std::invalid_argument{"unknown option " + arg};
         }
-        std::cout << std::endl;
+
+        if(max_depth < PROBCUT_MIN_DEPTH || max_depth >= PROBCUT_DEPTHS)
+            throw std::invalid_argument{"--depth must be between " + std::to_string(PROBCUT_MIN_DEPTH) + " and "
+                                        + std::to_string(PROBCUT_DEPTHS - 1)};
+    } catch(std::logic_error & e){
+        std::cout << "probcut: " << e.what() << '\n';
+        return 1;
+    }
+
+    // sample positions, at most one per game every few plies so that they are not too alike
+    std::vector<PackedPosition> samples;
+    if(!input.empty()){
+        PositionFileReader reader;
+        if(!reader.open(input)){
+            std::cout << "probcut: could not read " << input << '\n';
+            return 1;
+        }
+        for(std::size_t i = 0; i < reader.size() && static_cast<int>(samples.size()) < positions; ++i)
+            samples.push_back(reader[i]);
     } else {
-        std::cout << "White legal moves:\n";
-        auto x = getWhiteLegalMoves(board);
-        for ( const auto &vec : x ) {
-            std::cout << "(" << vec[0]  << "," << vec[1] << ")  ";
+        EngineConfig engine;
+        engine.depth = 2;
+        engine.probcut = 0;
+        std::mt19937 rng(seed);
+        while(static_cast<int>(samples.size()) < positions){
+            std::vector<uint8_t> moves = selfPlayGame(engine, rng, 0.3, 60);
+            char board[8][8];
+            initializeBoard(board);
+            char player = 'b';
+            int next_sample = std::uniform_int_distribution<int>(0, 7)(rng);
+            for(std::size_t ply = 0; ply < moves.size() && static_cast<int>(samples.size()) < positions; ++ply){
+                if(calculateLegalMoves(board, player).empty())
+                    player = (player == 'w') ? 'b' : 'w';
+                if(static_cast<int>(ply) == next_sample){
+                    PackedPosition sample;
+                    if(packPosition(board, player, sample))
+                        samples.push_back(sample);
+                    next_sample += 8;
+                }
+                makeMove(board, moves[ply] / 8, moves[ply] % 8, player);
+                player = (player == 'w') ? 'b' : 'w';
+            }
         }
-        std::cout << std::endl;
     }
-}
 
-// pass in a generated move list to "pretty print" them
-void printLegalMoves(std::vector<std::vector<int>> move_list){
-    for ( const auto &vec : move_list ){
-        std::cout << "(" << vec[0]  << "," << vec[1] << ")  ";
+    // values of every depth for every sample, computed concurrently
+    EngineConfig config;
+    config.probcut = 0;
+    config.endgame = 0; // a solve would report a single final score instead of one value per depth
+    std::vector<std::vector<int>> values(samples.size());
+    std::atomic<std::size_t> next_sample(0);
+    auto worker = [&](){
+        for(std::size_t i = next_sample++; i < samples.size(); i = next_sample++){
+            char board[8][8];
+            char player;
+            unpackPosition(samples[i], board, player);
+
+            SearchLimits limits;
+            limits.depth = max_depth;
+            std::atomic<bool> stop(false);
+            search(board, player, limits, config, stop, [&](const SearchResult & iteration){
+                values[i].push_back(iteration.score);
+            });
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < std::max(threads, 1); ++i)
+        workers.emplace_back(worker);
+    for(auto & t : workers)
+        t.join();
+
+    ProbCutFit fits[PROBCUT_STAGES][PROBCUT_DEPTHS];
+    for(std::size_t i = 0; i < samples.size(); ++i){
+        char board[8][8];
+        char player;
+        unpackPosition(samples[i], board, player);
+        int stage = probCutStage(board);
+        int sign = (player == 'b') ? 1 : -1;
+
+        // values[i][d - 1] is the value at depth d, fewer values when the game ends within the depth
+        for(int depth = PROBCUT_MIN_DEPTH; depth <= static_cast<int>(values[i].size()); ++depth)
+            fits[stage][depth].add(sign * values[i][probCutDepth(depth) - 1], sign * values[i][depth - 1]);
     }
-    std::cout << std::endl;
-}
 
-// overload the << operator to "pretty print" the board
-std::ostream& operator<<(std::ostream& os, const char board[8][8]){
-    std::cout << "   0  1  2  3  4  5  6  7\n";
-    for(int i = 0; i < 8; ++i){
-        std::cout << (i) << "  ";
-        for (int j = 0; j < 8; ++j) {
-            std::cout << board[i][j] << "  ";
+    std::cout << "// fitted by \"othello probcut\" on " << samples.size() << " positions\n"
+              << "const ProbCutModel PROBCUT_MODELS[PROBCUT_STAGES][PROBCUT_DEPTHS] = {\n";
+    for(int stage = 0; stage < PROBCUT_STAGES; ++stage){
+        std::cout << "    {";
+        // every depth of the table is printed, those beyond --depth without a model
+        for(int depth = 0; depth < PROBCUT_DEPTHS; ++depth){
+            ProbCutModel model = (depth >= PROBCUT_MIN_DEPTH && depth <= max_depth) ? fits[stage][depth].model()
+                                                                                  : ProbCutModel{0, 0, 0};
+            char text[64];
+            std::snprintf(text, sizeof(text), "%s{%.3f, %.2f, %.2f}", (depth > 0) ? ", " : "", model.a, model.b, model.sigma);
+            std::cout << text;
         }
-        std::cout << '\n';
+        std::cout << "},\n";
     }
-    return os;
+    std::cout << "};\n";
+    return 0;
 }
 
-// used to determine if the game is ended, makes sure at least 1 player has a move to make
-bool isGameOver(char board[8][8]){
-    return getBlackLegalMoves(board).empty() && getWhiteLegalMoves(board).empty();
-}
+// command line front-end for the binary position and game files:
+// othello pos pack <positions.txt> <out.pos>   text positions (one per line) to a position file
+// othello pos unpack <in.pos>                  position file to text positions
+// othello pos games <in.games>                 game file to text, each game as its start position and transcript
+int posCommand(int argc, char * argv[]){
+    std::string action = (argc > 2) ? argv[2] : "";
+    if(action == "pack" && argc == 5){
+        std::ifstream in(argv[3]);
+        if(!in){
+            std::cout << "pos: could not open " << argv[3] << '\n';
+            return 1;
+        }
 
-// go through whole board, and count pieces of passed-in player
-int getScore(char board[8][8], char player){
-    int total = 0;
-    for(int i = 0; i < 8; ++i)
-        for(int j = 0; j < 8; ++j)
-            if(board[i][j] == player)
-                total += 1;
+        try{
+            RecordFileWriter writer(argv[4], POSITION_FILE_MAGIC);
+            std::string line;
+            long long line_number = 0;
+            while(std::getline(in, line)){
+                line_number += 1;
+                char board[8][8];
+                char player;
+                if(line.empty())
+                    continue;
+                PackedPosition packed;
+                if(!positionFromText(line, board, player)){
+                    std::cout << "pos: skipping invalid position on line " << line_number << '\n';
+                    continue;
+                }
+                if(!packPosition(board, player, packed)){
+                    std::cout << "pos: skipping position with an empty d4 on line " << line_number
+                              << " (it has no packed form)\n";
+                    continue;
+                }
+                writer.writePosition(packed);
+            }
+            writer.close();
+        } catch(std::runtime_error & e){
+            std::cout << e.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
 
-    return total;
-}
+    if(action == "unpack" && argc == 4){
+        PositionFileReader reader;
+        if(!reader.open(argv[3])){
+            std::cout << "pos: could not read " << argv[3] << '\n';
+            return 1;
+        }
 
-// "pretty print" the winner of the game at the end of the game loop
-void printWinner(char (&board)[8][8]){
-    int white_total = getScore(board, 'w');
-    int black_total = getScore(board, 'b');
+        for(const PackedPosition & packed : reader){
+            char board[8][8];
+            char player;
+            unpackPosition(packed, board, player);
+            std::cout << positionToText(board, player) << '\n';
+        }
+        return 0;
+    }
 
-    std::cout << "Black total: " << black_total << '\n';
-    std::cout << "White total: " << white_total << '\n';
-    if(black_total == white_total){
-        std::cout << "TIE GAME\n";
-        return;
+    if(action == "games" && argc == 4){
+        GameFileReader reader;
+        if(!reader.open(argv[3])){
+            std::cout << "pos: could not read " << argv[3] << '\n';
+            return 1;
+        }
+
+        PackedPosition start;
+        const uint8_t * moves;
+        int move_count;
+        while(reader.next(start, moves, move_count)){
+            char board[8][8];
+            char player;
+            unpackPosition(start, board, player);
+            std::cout << positionToText(board, player) << ' ';
+            for(int i = 0; i < move_count; ++i)
+                std::cout << squareName(moves[i] / 8, moves[i] % 8);
+            std::cout << '\n';
+        }
+        return 0;
     }
 
-    std::cout << ((black_total > white_total) ? "Black" : "White") << " wins!\n";
+    std::cout << "usage: othello pos pack <positions.txt> <out.pos>\n"
+                 "       othello pos unpack <in.pos>\n"
+                 "       othello pos games <in.games>\n";
+    return 1;
 }
 
-// heursitic used to give value to varying states of the game
-int heuristic(char board[8][8]){
+// a fixed set of threads running jobs in submission order, shared by all sessions of a server
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int threads){
+        for(int i = 0; i < std::max(threads, 1); ++i)
+            threads_.emplace_back([this](){ run(); });
+    }
 
-    // intialize black and white total
-    int b_total = 0;
-    int w_total = 0;
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool & operator=(const WorkerPool &) = delete;
 
-    // factor in the amount of moves each player has
-    b_total += getBlackLegalMoves(board).size();
-    w_total += getWhiteLegalMoves(board).size();
+    // finishes the jobs that were already submitted, then joins the threads
+    ~WorkerPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for(auto & t : threads_)
+            t.join();
+    }
 
-    // factor in the amount of pieces each player has on the board
-    b_total += getScore(board, 'b');
-    w_total += getScore(board, 'w');
+    void submit(std::function<void()> job){
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        wake_.notify_one();
+    }
 
-    // factor in the importance of all 4 corners
-    if(board[0][0] == 'w'){
-        w_total += 10;
+private:
+    void run(){
+        while(true){
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this](){ return stopping_ || !jobs_.empty(); });
+                if(jobs_.empty())
+                    return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
     }
-    if(board[0][0] == 'b'){
-        b_total += 10;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()>> jobs_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// per-session settings chosen by whoever hosts the sessions
+struct SessionOptions
+{
+    std::size_t tt_megabytes = 0; // size of a transposition table owned by the session, 0 to use config.tt
+    int max_time_ms = 0; // upper bound for every search of the session (analyze included), 0 for none
+    std::function<void()> new_move; // told about every new move instead of aging config.tt (which is shared), may be empty
+};
+
+// ages a transposition table shared by many sessions: the sessions report their new moves and the generation
+// advances once for as many moves as there are sessions, about once per move of each game; aging it for every
+// session's move would wrap the 6-bit generation after a few moves of each game
+class SharedTableClock
+{
+public:
+    explicit SharedTableClock(TranspositionTable & tt) : tt_(tt) {}
+
+    void setSessions(std::size_t sessions){
+        sessions_ = std::max<std::size_t>(sessions, 1);
     }
-    if(board[7][0] == 'w'){
-        w_total += 10;
+
+    void newMove(){
+        if(++moves_ < sessions_)
+            return;
+        moves_ = 0;
+        tt_.newSearch();
     }
-    if(board[7][0] == 'b'){
-        b_total += 10;
+
+private:
+    TranspositionTable & tt_;
+    std::size_t sessions_ = 1;
+    std::size_t moves_ = 0;
+};
+
+// value below which the passed-in percentage of values falls (nearest rank), 0 for no values
+double percentile(std::vector<double> values, double percent){
+    if(values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    std::size_t rank = static_cast<std::size_t>(std::ceil(percent / 100.0 * values.size()));
+    return values[std::min(std::max(rank, std::size_t(1)), values.size()) - 1];
+}
+
+// engine side of the line based engine protocol (see protocolCommand), holds the position of one game;
+// searches run as jobs on a WorkerPool so that commands, "stop" in particular, are handled while the engine
+// thinks. Jobs keep the session alive, so sessions must be owned by a std::shared_ptr (use std::make_shared)
+class ProtocolSession : public std::enable_shared_from_this<ProtocolSession>
+{
+public:
+    // output receives every response line (without the newline), usually from a worker thread
+    ProtocolSession(const EngineConfig & config, WorkerPool & pool, std::function<void(const std::string &)> output,
+                    const SessionOptions & options = SessionOptions())
+        : config_(config), pool_(pool), output_(output), max_time_ms_(options.max_time_ms),
+          new_move_(options.new_move) {
+        initializeBoard(board_);
+        limits_.depth = config.depth;
+        limits_.time_ms = config.time_ms;
+        if(options.tt_megabytes > 0){
+            own_tt_.reset(new TranspositionTable(options.tt_megabytes));
+            config_.tt = own_tt_.get();
+        }
     }
-    if(board[0][7] == 'w'){
-        w_total += 10;
+
+    ProtocolSession(const ProtocolSession &) = delete;
+    ProtocolSession & operator=(const ProtocolSession &) = delete;
+
+    // handle one command line, returns false once the session should end
+    bool handleLine(const std::string & line){
+        std::istringstream in(line);
+        std::string command;
+        if(!(in >> command))
+            return true;
+
+        if(command == "quit"){
+            stop();
+            return false;
+        } else if(command == "ping"){
+            std::string id;
+            in >> id;
+            send("pong" + (id.empty() ? "" : " " + id));
+        } else if(command == "stop"){
+            stop();
+        } else if(command == "position"){
+            stop();
+            setPosition(in);
+        } else if(command == "moves" || command == "move"){
+            stop();
+            playMoves(in);
+        } else if(command == "undo" || command == "redo" || command == "goto"){
+            stop();
+            navigate(command, in);
+        } else if(command == "set"){
+            setOption(in);
+        } else if(command == "board"){
+            send("board " + positionToText(board_, player_));
+        } else if(command == "stats"){
+            sendStats();
+        } else if(command == "go"){
+            startSearch(moveLimits(), 0);
+        } else if(command == "analyze"){
+            SearchLimits infinite;
+            infinite.depth = 60;
+            infinite.time_ms = max_time_ms_;
+            startSearch(infinite, 0);
+        } else if(command == "hint"){
+            int count = 1;
+            in >> count;
+            startSearch(moveLimits(), std::max(count, 1));
+        } else {
+            send("error unknown command " + command);
+        }
+        return true;
     }
-    if(board[0][7] == 'b'){
-        b_total += 10;
+
+    // ask the running search and all queued ones to finish, they still report their results
+    void stop(){
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        if(running_stop_)
+            *running_stop_ = true;
+        for(auto & job : queued_)
+            *job.stop = true;
     }
-    if(board[7][7] == 'w'){
-        w_total += 10;
+
+    // block until every search of the session has reported its result
+    void wait(){
+        std::unique_lock<std::mutex> lock(jobs_mutex_);
+        jobs_done_.wait(lock, [this](){ return !running_ && queued_.empty(); });
     }
-    if(board[7][7] == 'b'){
-        b_total += 10;
+
+    // true when no search of the session is running or queued
+    bool idle(){
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        return !running_ && queued_.empty();
     }
 
-    // subtract white's total from black, let black be the maximizer
-    return (b_total-w_total);
-}
+    // time between receiving go/hint and sending their answer, in milliseconds
+    std::vector<double> latencies(){
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return latencies_;
+    }
 
-// a node which will be part of the game tree, main pieces of info include: state (board configuration) & associated value
-struct Node
-{
-    Node ** children;
-    int child_count;
-    std::vector<std::vector<int>> move_list;
-    char state[8][8];
-    int val;
-};
+private:
+    struct SearchJob
+    {
+        std::shared_ptr<std::atomic<bool>> stop;
+        std::function<void()> run;
+    };
+
+    // position startpos | <64 squares> <player> [moves <square>...]
+    void setPosition(std::istringstream & in){
+        std::string squares, side;
+        in >> squares;
+        history_.clear();
+        if(squares == "startpos"){
+            initializeBoard(board_);
+            player_ = 'b';
+        } else {
+            in >> side;
+            char board[8][8];
+            char player;
+            if(!positionFromText(squares + " " + side, board, player)){
+                send("error invalid position");
+                return;
+            }
+            std::memcpy(board_, board, 8 * 8 * sizeof(char));
+            player_ = player;
+        }
 
-// method used to initialize a game tree (called everytime the AI has a turn)
-Node * CreateTree(char board[8][8], int depth, char player)
-{
-    Node * node = new Node();
+        std::string keyword;
+        if(in >> keyword){
+            if(keyword == "moves")
+                playMoves(in);
+            else
+                send("error expected moves after the position");
+        }
+    }
 
-    // get the appropriate list moves
-    node->move_list = (player == 'w') ? getWhiteLegalMoves(board) : getBlackLegalMoves(board);
+    // play squares such as "f5" one after the other, passes are implied (an explicit "pass" is accepted too)
+    void playMoves(std::istringstream & in){
+        std::string name;
+        while(in >> name){
+            if(name == "pass"){
+                if(!calculateLegalMoves(board_, player_).empty()){
+                    send("error illegal move pass");
+                    return;
+                }
+                history_.pass(player_);
+                player_ = (player_ == 'w') ? 'b' : 'w';
+                continue;
+            }
 
-    // keep a count of children for indexes later on
-    node->child_count = node->move_list.size();
+            int row, col;
+            char player = player_;
+            if(!parseSquare(name, row, col) || !recordedMoveIsLegal(board_, player, row, col)){
+                send("error illegal move " + name);
+                return;
+            }
+            if(player != player_) // implied pass
+                history_.pass(player_);
+            history_.play(board_, row, col, player);
+            player_ = (player == 'w') ? 'b' : 'w';
+        }
+    }
 
-    // copy the passed in board state to the state of the current node
-    std::memcpy(node->state, board, 8 * 8 * sizeof(char));
+    // undo [plies] | redo [plies] | goto <ply>, walk through the moves played since the last position command
+    void navigate(const std::string & command, std::istringstream & in){
+        int count = 1;
+        if(command == "goto"){
+            if(!(in >> count) || !history_.goTo(board_, player_, count))
+                send("error usage: goto <ply> with a ply between 0 and " + std::to_string(history_.length()));
+            return;
+        }
 
-    // determine other player's character
-    char other_player = (player == 'w') ? 'b' : 'w';
+        in >> count;
+        for(int i = 0; i < count; ++i){
+            bool done = (command == "undo") ? history_.undo(board_, player_) : history_.redo(board_, player_);
+            if(!done){
+                send("error nothing to " + command);
+                return;
+            }
+        }
+    }
 
-    // only create children if we're not too deep and this node should have children
-    if (depth > 0 && node->child_count > 0) {
-        // create an array of nodes as the children of the current node
-        node->children = new Node * [node->child_count];
+    // set depth <plies> | set time <milliseconds> | set budget <milliseconds>
+    void setOption(std::istringstream & in){
+        std::string name;
+        long long value;
+        if(!(in >> name >> value) || value < 0){
+            send("error usage: set depth <plies> | set time <milliseconds> | set budget <milliseconds>");
+            return;
+        }
 
-        // cycle through the children and create nodes for them
-        for (int i = 0; i < node->child_count; ++i){
-            char tmp_board[8][8];
-            std::memcpy(tmp_board, board, 8 * 8 * sizeof(char));
+        if(name == "depth" && value >= 1){
+            limits_.depth = static_cast<int>(std::min(value, 60LL));
+            depth_set_ = true;
+        }
+        else if(name == "time")
+            limits_.time_ms = static_cast<int>(std::min(value, 1000000000LL));
+        else if(name == "budget")
+            budget_ms_ = value;
+        else
+            send("error unknown option " + name);
+    }
 
-            // must make the associating move first so a subtree of 'that' board configuration can be created
-            makeMove(tmp_board, node->move_list[i][0], node->move_list[i][1], player);
+    // limits for go/hint: the session's limits, capped by the share of the game's time budget this move may use
+    SearchLimits moveLimits(){
+        SearchLimits limits = limits_;
+        if(!depth_set_) // like the engine's own moves, solve the endgame (see engineLimits())
+            limits.depth = engineLimits(board_, config_).depth;
+        long long budget = budget_ms_.load();
+        if(budget >= 0){
+            int empties = 64 - getScore(board_, 'b') - getScore(board_, 'w');
+            long long share = std::max(budget / std::max((empties + 1) / 2, 1), 1LL); // remaining moves of this player
+            limits.time_ms = (limits.time_ms > 0) ? static_cast<int>(std::min<long long>(limits.time_ms, share))
+                                                  : static_cast<int>(std::min(share, 1000000000LL));
+        }
+        if(max_time_ms_ > 0)
+            limits.time_ms = (limits.time_ms > 0) ? std::min(limits.time_ms, max_time_ms_) : max_time_ms_;
+        return limits;
+    }
 
-            // turn the child into a tree itself
-            node->children[i] = CreateTree(tmp_board, depth - 1, other_player);
+    // queue a search of the current position, for hint_count > 0 the scores of the hint_count best moves are
+    // reported instead of a single best move; earlier searches of the session are told to stop
+    void startSearch(const SearchLimits & limits, int hint_count){
+        auto stop_flag = std::make_shared<std::atomic<bool>>(false);
+        auto received = std::chrono::steady_clock::now();
+        bool use_budget = (budget_ms_.load() >= 0);
+
+        // a search of a new position is a new move of the game, the session's own table is aged once for it (and
+        // not again for a second go or hint on the same position), a shared one by whoever shares it
+        uint64_t position = hashPosition(board_, player_);
+        if(position != searched_position_){
+            if(own_tt_)
+                own_tt_->newSearch();
+            else if(new_move_)
+                new_move_();
         }
-    } else {
-        node->children = NULL;
+        searched_position_ = position;
+
+        char board[8][8];
+        std::memcpy(board, board_, 8 * 8 * sizeof(char));
+        char player = player_;
+        auto self = shared_from_this();
+        SearchJob job;
+        job.stop = stop_flag;
+        job.run = [self, board, player, limits, hint_count, stop_flag, received, use_budget]() mutable {
+            auto started = std::chrono::steady_clock::now();
+            std::vector<std::string> answer = self->runSearch(board, player, limits, hint_count, *stop_flag);
+
+            auto finished = std::chrono::steady_clock::now();
+            if(use_budget){
+                long long used = std::chrono::duration_cast<std::chrono::milliseconds>(finished - started).count();
+                self->budget_ms_ = std::max(self->budget_ms_.load() - used, 0LL);
+            }
+            {
+                std::lock_guard<std::mutex> lock(self->stats_mutex_);
+                self->latencies_.push_back(std::chrono::duration<double, std::milli>(finished - received).count());
+            }
+
+            for(const auto & line : answer)
+                self->send(line);
+        };
+
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        if(running_stop_)
+            *running_stop_ = true;
+        for(auto & queued : queued_)
+            *queued.stop = true;
+        queued_.push_back(job);
+        if(!running_)
+            submitNextLocked();
+    }
+
+    // hand the next queued search to the pool, searches of one session run one after the other so that their
+    // answers come out in order (jobs_mutex_ must be held)
+    void submitNextLocked(){
+        SearchJob job = queued_.front();
+        queued_.pop_front();
+        running_ = true;
+        running_stop_ = job.stop;
+
+        auto self = shared_from_this();
+        pool_.submit([self, job](){
+            job.run();
+
+            std::lock_guard<std::mutex> lock(self->jobs_mutex_);
+            self->running_ = false;
+            self->running_stop_.reset();
+            if(!self->queued_.empty())
+                self->submitNextLocked();
+            else
+                self->jobs_done_.notify_all();
+        });
+    }
+
+    // the search itself, runs on a worker thread; progress is sent right away, the final answer is returned so
+    // that the search's statistics are up to date by the time the client sees it
+    std::vector<std::string> runSearch(char (&board)[8][8], char player, const SearchLimits & limits, int hint_count,
+                                       const std::atomic<bool> & stop){
+        // scores are reported from the point of view of the player to move
+        int sign = (player == 'b') ? 1 : -1;
+
+        if(hint_count > 0){
+            std::vector<std::string> lines;
+            std::vector<MoveScore> scores = scoreMoves(board, player, limits, config_, stop, hint_count);
+            for(std::size_t i = 0; i < scores.size() && static_cast<int>(i) < hint_count; ++i)
+                lines.push_back("hint " + squareName(scores[i].move / 8, scores[i].move % 8) + " " + std::to_string(sign * scores[i].score));
+            lines.push_back("hint end");
+            return lines;
+        }
+
+        if(config_.book != NULL){
+            uint8_t book_move = probeBook(*config_.book, board, player);
+            if(book_move != NO_MOVE)
+                return {"bestmove " + squareName(book_move / 8, book_move % 8) + " book"};
+        }
+
+        SearchResult result = search(board, player, limits, config_, stop, [&](const SearchResult & iteration){
+            send("info depth " + std::to_string(iteration.depth) + " score " + std::to_string(sign * iteration.score)
+                 + " nodes " + std::to_string(iteration.nodes)
+                 + " time " + std::to_string(static_cast<long long>(iteration.seconds * 1000))
+                 + " move " + squareName(iteration.move / 8, iteration.move % 8));
+        });
+
+        if(result.move == NO_MOVE)
+            return {"bestmove pass"};
+        return {"bestmove " + squareName(result.move / 8, result.move % 8) + " score " + std::to_string(sign * result.score)
+                + " depth " + std::to_string(result.depth) + " nodes " + std::to_string(result.nodes)
+                + " etc " + std::to_string(result.etc_cutoffs)
+                + " time " + std::to_string(static_cast<long long>(result.seconds * 1000))};
+    }
+
+    void sendStats(){
+        std::vector<double> values = latencies();
+        std::ostringstream out;
+        out << "stats searches " << values.size() << " p50 " << percentile(values, 50) << " p90 " << percentile(values, 90)
+            << " p99 " << percentile(values, 99) << " max " << percentile(values, 100);
+        send(out.str());
+    }
+
+    void send(const std::string & line){
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        output_(line);
     }
 
-    return node;
+    EngineConfig config_;
+    std::unique_ptr<TranspositionTable> own_tt_;
+    WorkerPool & pool_;
+    std::function<void(const std::string &)> output_;
+    std::mutex output_mutex_;
+    int max_time_ms_;
+    std::function<void()> new_move_;
+
+    // game state, only touched by the thread calling handleLine()
+    SearchLimits limits_;
+    bool depth_set_ = false; // limits_.depth was set with "set depth" instead of coming from the configuration
+    char board_[8][8];
+    char player_ = 'b';
+    uint64_t searched_position_ = 0; // hashPosition() of the position of the last go/hint/analyze
+    GameHistory history_; // moves played on board_ since the last position command
+    std::atomic<long long> budget_ms_{-1}; // thinking time left for the game, -1 for no budget
+
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_done_;
+    std::deque<SearchJob> queued_;
+    std::shared_ptr<std::atomic<bool>> running_stop_;
+    bool running_ = false;
+
+    std::mutex stats_mutex_;
+    std::vector<double> latencies_;
+};
+
+// run the engine protocol over stdin/stdout until "quit" or the end of the input:
+//   position startpos | <64 squares> <player> [moves <square>...]   set up a position (see positionToText)
+//   moves <square>...                 play moves on the current position, passes are implied
+//   undo [n] | redo [n]               take back the last n moves (default 1) or play taken back moves again
+//   goto <ply>                        undo or redo up to ply (0 for the position set with the position command)
+//   set depth <plies> | set time <ms> search limits used by go and hint
+//   set budget <ms>                   total thinking time for the rest of the game, shared out over the moves
+//   go                                search, prints "info ..." after every iteration and then "bestmove ..."
+//                                     (or "bestmove <square> book" for opening book moves)
+//   analyze                           search without limits until stop, reporting like go
+//   hint <n>                          prints "hint <square> <score>" for the n best moves, then "hint end"
+//   stop                              end the running search, which reports its best move right away
+//   board                             prints "board <64 squares> <player>"
+//   stats                             prints "stats searches <n> p50 <ms> p90 <ms> p99 <ms> max <ms>"
+//   ping <id>                         prints "pong <id>"
+//   quit
+// scores are heuristic values (final disc differences once the endgame is solved) from the point of view of the
+// player to move, "etc" in bestmove counts enhanced transposition cutoffs
+int protocolCommand(const EngineConfig & config){
+    WorkerPool pool(1);
+    SessionOptions options;
+    options.tt_megabytes = TT_MEGABYTES;
+    auto session = std::make_shared<ProtocolSession>(config, pool, [](const std::string & line){
+        std::cout << line << std::endl;
+    }, options);
+
+    std::string line;
+    while(std::getline(std::cin, line)){
+        if(!session->handleLine(line))
+            break;
+    }
+
+    session->stop();
+    session->wait();
+    return 0;
 }
 
-// crucial minimax method for making smart AI choices (other methods may be added in the future)
-int minimax(Node *position, int depth, int alpha, int beta, bool maximizing_player){
+// the socket of one server client, closed once the client goes away (searches may still try to answer it)
+struct ClientConnection
+{
+    int fd;
+    bool open = true;
+    std::mutex mutex;
+
+    void send(const std::string & line){
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string data = line + '\n';
+        std::size_t sent = 0;
+        while(open && sent < data.size()){
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if(n <= 0)
+                break; // the client is gone, the read side notices and closes the connection
+            sent += static_cast<std::size_t>(n);
+        }
+    }
+
+    void close(){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(open)
+            ::close(fd);
+        open = false;
+    }
+};
+
+// serve many games at once: every client connection is a session speaking the engine protocol (see
+// protocolCommand) and all sessions share one pool of search threads, the evaluation weights and the book
+// othello server [--socket <path> | --port <n>] [--threads N] [--tt shared|session] [--tt-mb N] [--max-time MS]
+int serverCommand(int argc, char * argv[]){
+    std::string socket_path = "othello.sock";
+    int port = 0;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool shared_tt = true;
+    SessionOptions options;
+    options.max_time_ms = SERVER_MAX_TIME_MS;
+    std::size_t tt_megabytes = TT_MEGABYTES;
+
+    try{
+        for(int i = 2; i < argc; ++i){
+            std::string arg = argv[i];
+            if(i + 1 >= argc)
+                throw std::invalid_argument{"missing value for " + arg};
+            std::string value = argv[++i];
+
+            if(arg == "--socket")
+                socket_path = value;
+            else if(arg == "--port")
+                port = std::stoi(value);
+            else if(arg == "--threads")
+                threads = std::stoi(value);
+            else if(arg == "--tt" && (value == "shared" || value == "session"))
+                shared_tt = (value == "shared");
+            else if(arg == "--tt-mb")
+                tt_megabytes = static_cast<std::size_t>(std::stoul(value));
+            else if(arg == "--max-time")
+                options.max_time_ms = std::stoi(value);
+            else
+                throw std::invalid_argument{"unknown option " + arg + " " + value};
+        }
+    } catch(std::logic_error & e){
+        std::cout << "server: " << e.what() << '\n';
+        return 1;
+    }
 
-    // if we're at the final layer or this state is a dead sate, return static heurstic
-    if(depth == 0 || isGameOver(position->state)){
-        //std::cout<< "returning heursitic: " << heuristic(position->state) << '\n';
-        return heuristic(position->state);
+    // read-only state shared by every session
+    EngineConfig config;
+    OpeningBook book;
+    if(book.open(OPENING_BOOK_PATH))
+        config.book = &book;
+    std::unique_ptr<TranspositionTable> tt;
+    std::unique_ptr<SharedTableClock> clock;
+    if(shared_tt){
+        tt.reset(new TranspositionTable(tt_megabytes));
+        config.tt = tt.get();
+        clock.reset(new SharedTableClock(*tt));
+        SharedTableClock * shared_clock = clock.get();
+        options.new_move = [shared_clock](){ shared_clock->newMove(); }; // sessions start searches on this thread
+    } else {
+        options.tt_megabytes = tt_megabytes;
     }
 
-    // if maximizing layer...
-    if(maximizing_player){
-        int max_eval = -9999999; // set max to worst case
+    int listener;
+    if(port > 0){
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0){
+            std::cout << "server: could not bind to port " << port << '\n';
+            return 1;
+        }
+    } else {
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if(socket_path.size() >= sizeof(address.sun_path)){
+            std::cout << "server: socket path too long\n";
+            return 1;
+        }
+        std::strcpy(address.sun_path, socket_path.c_str());
+        unlink(socket_path.c_str()); // left behind by a previous run
+        if(listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0){
+            std::cout << "server: could not bind to " << socket_path << '\n';
+            return 1;
+        }
+    }
+    listen(listener, 64);
+    std::cerr << "Serving on " << ((port > 0) ? "127.0.0.1:" + std::to_string(port) : socket_path) << " with "
+              << threads << " search threads, " << (shared_tt ? "shared" : "per-session") << " transposition table\n";
+
+    WorkerPool pool(threads);
+    struct Client
+    {
+        std::shared_ptr<ClientConnection> connection;
+        std::shared_ptr<ProtocolSession> session;
+        std::string buffer; // input received after the last complete line
+        long long id;
+    };
+    std::vector<Client> clients;
+    std::vector<Client> closing; // disconnected clients whose searches haven't finished yet
+    long long next_id = 1;
+
+    // one thread multiplexes all connections, reading commands and handing searches to the pool
+    while(true){
+        if(clock)
+            clock->setSessions(clients.size());
+
+        std::vector<pollfd> fds(1 + clients.size());
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        for(std::size_t i = 0; i < clients.size(); ++i){
+            fds[i + 1].fd = clients[i].connection->fd;
+            fds[i + 1].events = POLLIN;
+        }
 
-        // for all of the children nodes, recursively call minimax
-        // decrease the depth parameter with each call, so we can guarantee we will get to the base case above
-        for(int i = 0; i < position->child_count; ++i){
-            int eval = minimax(position->children[i], depth - 1, alpha, beta, false);
-            max_eval = std::max(max_eval, eval); // update max if evaluation is >
+        if(poll(fds.data(), fds.size(), closing.empty() ? -1 : 100) < 0){
+            if(errno == EINTR)
+                continue;
+            break;
+        }
 
-            //update alpha appropriately, and check for eligibility of alpha prune
-            alpha = std::max(alpha, eval);
-            if(beta <= alpha) {
-                if (DEBUG_MODE) {
-                    std::cout << "DEBUG: PRUNED " << (position->child_count - (i+1)) << " children.\n";
+        std::vector<Client> remaining;
+        for(std::size_t i = 0; i < clients.size(); ++i){
+            Client & client = clients[i];
+            bool keep = true;
+            if(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)){
+                char data[4096];
+                ssize_t n = recv(client.connection->fd, data, sizeof(data), 0);
+                if(n <= 0){
+                    keep = false;
+                } else {
+                    client.buffer.append(data, static_cast<std::size_t>(n));
+                    std::string::size_type newline;
+                    while(keep && (newline = client.buffer.find('\n')) != std::string::npos){
+                        std::string line = client.buffer.substr(0, newline);
+                        client.buffer.erase(0, newline + 1);
+                        if(!line.empty() && line.back() == '\r')
+                            line.pop_back();
+                        keep = client.session->handleLine(line);
+                    }
                 }
-                break;
             }
+
+            if(keep){
+                remaining.push_back(client);
+                continue;
+            }
+
+            // searches still running for this client finish on their own and keep the session alive until then
+            client.session->stop();
+            client.connection->close();
+            closing.push_back(client);
         }
-        position->val = max_eval; // store the max_eval in this node
-        return max_eval;
-    } else { // minimizing layer...
-        int min_eval = 9999999; // set min to worst case
-        for(int i = 0; i < position->child_count; ++i){
-            int eval = minimax(position->children[i], depth -1, alpha, beta, true);
-            min_eval = std::min(min_eval, eval); // update min if evaluation is <
+        clients.swap(remaining);
 
-            // update beta appropriately, and check for eligibility of beta prune
-            beta = std::min(beta, eval);
-            if(beta <= alpha)
-                break;
+        // report the latencies of closed sessions once their last search is done
+        std::vector<Client> still_closing;
+        for(auto & client : closing){
+            if(!client.session->idle()){
+                still_closing.push_back(client);
+                continue;
+            }
+            std::vector<double> values = client.session->latencies();
+            std::cerr << "Session " << client.id << " closed after " << values.size() << " searches, latency p50 "
+                      << percentile(values, 50) << "ms p90 " << percentile(values, 90) << "ms p99 "
+                      << percentile(values, 99) << "ms max " << percentile(values, 100) << "ms\n";
+        }
+        closing.swap(still_closing);
+
+        if(fds[0].revents & POLLIN){
+            int fd = accept(listener, NULL, NULL);
+            if(fd >= 0){
+                Client client;
+                client.connection = std::make_shared<ClientConnection>();
+                client.connection->fd = fd;
+                std::shared_ptr<ClientConnection> connection = client.connection;
+                client.session = std::make_shared<ProtocolSession>(config, pool, [connection](const std::string & line){
+                    connection->send(line);
+                }, options);
+                client.id = next_id++;
+                clients.push_back(client);
+            }
         }
-        position->val = min_eval; // store min_eval in this node
-        return min_eval;
     }
-}
 
-// simplified minimax without alpha-beta pruning, similar to above
-int minimax(Node *position, int depth, bool maximizing_player){
-    //std::cout << "DEPTH = " << depth << '\n';
-    if(depth == 0 || isGameOver(position->state)){
-        //std::cout<< "returning heursitic: " << heuristic(position->state) << '\n';
-        return heuristic(position->state);
-    }
+    close(listener);
+    return 1;
+}
 
-    if(maximizing_player){
-        int max_eval = -9999999;
-        for(int i = 0; i < position->child_count; ++i){
-            int eval = minimax(position->children[i], depth - 1, false);
-            max_eval = std::max(max_eval, eval);
+// handle the history commands of the console game: "undo", "redo" and "goto <ply>" (0 for the start of the game);
+// returns false if the input isn't one of them. Against the AI (human is the human's piece, 0 otherwise) undo and
+// redo walk on until the human has a move to make, so that the AI's answer is taken back together with the move
+bool navigateHistory(const std::string & input, GameHistory & history, char (&board)[8][8], char & player,
+                     char human = 0){
+    std::istringstream in(input);
+    std::string command;
+    in >> command;
+
+    if(command == "undo"){
+        if(!history.undo(board, player)){
+            std::cout << "Nothing to undo.\n\n";
+            return true;
         }
-        position->val = max_eval;
-        return max_eval;
-    } else {
-        int min_eval = 9999999;
-        for(int i = 0; i < position->child_count; ++i){
-            int eval = minimax(position->children[i], depth -1, true);
-            min_eval = std::min(min_eval, eval);
+        while(human != 0 && (player != human || calculateLegalMoves(board, player).empty())
+              && history.undo(board, player))
+            ;
+    } else if(command == "redo"){
+        if(!history.redo(board, player)){
+            std::cout << "Nothing to redo.\n\n";
+            return true;
+        }
+        while(human != 0 && (player != human || calculateLegalMoves(board, player).empty())
+              && history.redo(board, player))
+            ;
+    } else if(command == "goto"){
+        int ply;
+        if(!(in >> ply) || !history.goTo(board, player, ply)){
+            std::cout << "Enter 'goto <ply>' with a ply between 0 and " << history.length() << ".\n\n";
+            return true;
         }
-        position->val = min_eval;
-        return min_eval;
+    } else {
+        return false;
     }
+
+    std::cout << "Ply " << history.ply() << " of " << history.length() << ".\n\n";
+    return true;
 }
 
-int main() {
+int main(int argc, char * argv[]) {
+
+    if(argc > 1 && std::string(argv[1]) == "tournament")
+        return tournamentCommand(argc, argv);
+    if(argc > 1 && std::string(argv[1]) == "book")
+        return bookCommand(argc, argv);
+    if(argc > 1 && std::string(argv[1]) == "wthor")
+        return wthorCommand(argc, argv);
+    if(argc > 1 && std::string(argv[1]) == "pos")
+        return posCommand(argc, argv);
+    if(argc > 1 && std::string(argv[1]) == "probcut")
+        return probCutCommand(argc, argv);
+    if(argc > 1 && std::string(argv[1]) == "protocol"){
+        EngineConfig config;
+        OpeningBook book;
+        if(book.open(OPENING_BOOK_PATH))
+            config.book = &book;
+        return protocolCommand(config);
+    }
+    if(argc > 1 && std::string(argv[1]) == "server")
+        return serverCommand(argc, argv);
 
     std::cout << "This CLI program is a playable Othello game, which consists of two players\n"
                  "('w' and 'b') competing for space on a 8x8 square grid. Flanking your opponent \n"
@@ -476,21 +1777,15 @@ int main() {
                  "If no such move exists, you pass your turn to your opponent. Black always plays the\n"
                  "first move.\n\n"
                  "Make your moves to the grid by entering '<row #> <column #>' with numbers [0-7].\n"
+                 "Enter 'undo' or 'redo' to take back or replay moves and 'goto <ply>' to jump to any point of the game.\n"
                  "Good luck!\n\n";
 
     //**** Initialize Game Board *********
     char board[8][8];
-    for(auto & i : board){
-        for (char & j : i) {
-            j = '-';
-        }
-    }
-
-    board[3][3] = 'w'; board[3][4] = 'b';
-    board[4][3] = 'b'; board[4][4] = 'w';
+    initializeBoard(board);
     //************************************
 
-    int total_moves = 0;
+    GameHistory history; // every move of the game, for undo/redo/goto
     char player = 'b'; // black always goes first
     std::regex move_input_pattern("[0-7] [0-7]"); // regex for row/col input
 
@@ -513,23 +1808,38 @@ int main() {
         char player_char = selected_player[0];
         std::cout << "You have chosen to play as " << ((player_char == 'w') ? "white" : "black") << "!\n\n";
 
-        // set AI as the opposite of what the player chose
-        char ai_char = ((player_char == 'w') ? 'b' : 'w');
+        EngineConfig ai_config; // default engine configuration (MINIMAX_DEPTH, alpha-beta, default weights)
+        TranspositionTable tt(TT_MEGABYTES); // kept for the whole game so that pondering can warm it up
+        ai_config.tt = &tt;
+        Ponderer ponderer;
+
+        // skip the search for well known openings when an opening book is available
+        OpeningBook book;
+        if(book.open(OPENING_BOOK_PATH)){
+            ai_config.book = &book;
+            std::cout << "Loaded opening book with " << book.size() << " positions.\n\n";
+        }
+
+        // after undo/redo/goto the AI waits to be told to move, so that looking around the game doesn't replace the
+        // moves after the current ply with the AI's choices
+        bool reviewing = false;
 
         // main game loop
         while(!isGameOver(board)){
             // calculate the move list of the current player
-            std::vector<std::vector<int>> move_list = calculateLegalMoves(board, player);
+            MoveList move_list = calculateLegalMoves(board, player);
 
             //************ TURN PASS CONDITIONS **********************
             if (player == 'b' && getBlackLegalMoves(board).empty()){
                 //std::cout << "Black is out of moves, PASS to White.\n";
+                history.pass(player);
                 player = 'w';
                 continue;
             }
 
             if (player == 'w' && getWhiteLegalMoves(board).empty()){
                 //std::cout << "White is out of moves, PASS to Black.\n";
+                history.pass(player);
                 player = 'b';
                 continue;
             }
@@ -544,16 +1854,32 @@ int main() {
             std::cout << board; // show board
             std::cout << '\n';
             if(player == player_char){
-                printLegalMoves(board, player_char); // show possible moves
+                if(COACH){
+                    // show possible moves together with how good the AI thinks they are
+                    std::atomic<bool> stop(false);
+                    printLegalMoves(player_char, scoreMoves(board, player_char, engineLimits(board, ai_config), ai_config,
+                                                            stop));
+                } else {
+                    printLegalMoves(board, player_char); // show possible moves
+                }
+
+                // think about the AI's answers while the human decides
+                if(PONDER)
+                    ponderer.start(board, player, ai_config);
 
                 std::string user_input;
+                bool navigated = false; // the human moved through the history instead of playing
                 // loop until user provides a legal move in the correct row/col format
                 while(true){
                     // Print input prompt
                     std::cout << ((player == 'w') ? "Your move (w): " : "Your move (b): ");
                     std::getline(std::cin, user_input);
 
-                    if(!std::regex_match(user_input, move_input_pattern)){
+                    if(navigateHistory(user_input, history, board, player, player_char)){
+                        navigated = true;
+                        reviewing = true;
+                        break;
+                    } else if(!std::regex_match(user_input, move_input_pattern)){
                         std::cout << "\nInvalid input: Moves are inputted as '<row #> <column #>' with numbers [0-7].\n";
                         std::cout << "e.g. If you want to place your piece at row #1, column #2 input '1 2'.\n\n";
                         continue;
@@ -566,7 +1892,8 @@ int main() {
                         try{
                             // if the inserted move is legal, make the move
                             if(isLegalMove(board, move_list, row, col, player)){
-                                makeMove(board, row, col, player);
+                                history.play(board, row, col, player);
+                                reviewing = false;
                             } else {
                                 std::cout << "Illegal move! Try again.\n";
                                 continue;
@@ -580,50 +1907,36 @@ int main() {
 
                 }
                 // user has finished turn
+                ponderer.stop();
+                if(navigated) // show the position the human went to, player has been set by the history
+                    continue;
 
             } else { // AI turn
-                    auto gametree = CreateTree(board, MINIMAX_DEPTH, player); // game tree representing MINIMAX_DEPTH decisions
-                    bool maximizer = (player == 'b') ? true : false;
-
-                    // find optimal value
-                    int optimial_val = minimax(gametree, MINIMAX_DEPTH, -99999999, 99999999, maximizer);
-                    //int optimial_val = minimax(gametree, MINIMAX_DEPTH, maximizer);
-
-                    if(DEBUG_MODE){
-                        std::cout << "DEBUG: AI considered " << gametree->child_count << " initial moves for this board configuration.\n";
-                        printLegalMoves(gametree->move_list);
-                        for(int i = 0; i < gametree->child_count; ++i){
-                            std::cout << "\t" << i << "th node's heuristic value = " << gametree->children[i]->val << '\n';
+                    if(reviewing){
+                        std::cout << "AI to move (" << player << "), press Enter to let it play or undo/redo/goto: ";
+                        std::string user_input;
+                        if(!std::getline(std::cin, user_input))
+                            return 0;
+                        if(navigateHistory(user_input, history, board, player, player_char))
+                            continue;
+                        if(!user_input.empty()){
+                            std::cout << "\nInvalid input: Press Enter for the AI's move or enter undo, redo or goto.\n\n";
+                            continue;
                         }
-                        std::cout << '\n';
+                        reviewing = false;
                     }
 
-                    //std::cout << "Optimal val: " << optimial_val << '\n';
-                    // loop through children of root node to find the node with the optimal value
-                    for(int i = 0; i < gametree->child_count; ++i){
-                        //std::cout << gametree->children[i]->val << '\n';
-                        if(gametree->children[i]->val == optimial_val){
-                            bool same_config = true;
-                            for(int j = 0; j < 7; ++j){
-                                for(int k = 0; k < 7; ++k){
-                                    if(gametree->children[i]->state[j][k] != board[j][k])
-                                        same_config = false;
-                                }
-                            }
-                            //std::cout << "the " << i << "th child of gametree has the optimizal value.\n";
-
-                            // copy this optimial choice of node's state into the main game board
-                            if(!same_config)
-                                std::memcpy(board, gametree->children[i]->state, 8 * 8 * sizeof(char));
-                            else{ // if no good move for ai, just pick the first move from the legal move list
-                                makeMove(board, move_list[0][0], move_list[0][1], player);
-                            }
-                            break;
-                        }
-                    }
+                    // pondering may already have prepared the answer to the human's move
+                    uint8_t ai_move = NO_MOVE;
+                    if(ai_config.book == NULL || probeBook(*ai_config.book, board, player) == NO_MOVE)
+                        ai_move = ponderer.readyMove(board);
+                    if(DEBUG_MODE && ai_move != NO_MOVE)
+                        std::cout << "DEBUG: AI answered with its pondered move.\n\n";
+                    if(ai_move == NO_MOVE)
+                        ai_move = chooseMove(board, player, ai_config);
+                    history.play(board, ai_move / 8, ai_move % 8, player);
             }
 
-            total_moves += 1;
             //std::cout << '\n' << gb; // Show board
 
             // Switch players
@@ -633,7 +1946,7 @@ int main() {
 
     } else { // Playing 2 player game
         while(!isGameOver(board)){
-            std::vector<std::vector<int>> move_list = calculateLegalMoves(board, player);
+            MoveList move_list = calculateLegalMoves(board, player);
 
             std::cout << ((player == 'w') ? "White's Movelist: " : "Black's Movelist: \n");
             printLegalMoves(move_list);
@@ -641,12 +1954,14 @@ int main() {
 
             if (player == 'b' && getBlackLegalMoves(board).size() == 0){
                 //std::cout << "Black is out of moves, PASS to White.\n";
+                history.pass(player);
                 player = 'w';
                 continue;
             }
 
             if (player == 'w' && getWhiteLegalMoves(board).size() == 0){
                 //std::cout << "White is out of moves, PASS to Black.\n";
+                history.pass(player);
                 player = 'b';
                 continue;
             }
@@ -658,6 +1973,9 @@ int main() {
             std::getline(std::cin, user_input);
             //std::cout << "You entered: " << user_input << '\n';
 
+            if(navigateHistory(user_input, history, board, player))
+                continue;
+
             if(!std::regex_match(user_input, move_input_pattern)){
                 std::cout << "\nInvalid input: Moves are inputted as '<row #> <column #>' with numbers [1-8].\n";
                 std::cout << "e.g. If you want to place your piece at row #1, column #2 input '1 2'.\n\n";
@@ -671,7 +1989,7 @@ int main() {
 
             try{
                 if(isLegalMove(board, move_list, row, col, player)){
-                    makeMove(board, row, col, player);
+                    history.play(board, row, col, player);
                 } else {
                     std::cout << "Illegal move! Try again.\n";
                     continue;
@@ -681,7 +1999,6 @@ int main() {
                 return 1;
             }
 
-            total_moves += 1;
             int white_total = getScore(board, 'w');
             int black_total = getScore(board, 'b');
 
@@ -0,0 +1,276 @@
+#include "othello/board.h"
+
+#include <cctype>
+#include <stdexcept>
+
+void flip(char (&board)[8][8], int row, int col, char player){
+    if(player == 'b')
+        flip<'b'>(board, row, col);
+    else
+        flip<'w'>(board, row, col);
+}
+
+bool isFlippable(char board[8][8], int row, int col, char player) {
+    return (player == 'b') ? isFlippable<'b'>(board, row, col) : isFlippable<'w'>(board, row, col);
+}
+
+void makeMove(char (&board)[8][8], int row, int col, char player){
+    if(player == 'b')
+        makeMove<'b'>(board, row, col);
+    else
+        makeMove<'w'>(board, row, col);
+}
+
+uint64_t flipMask(char board[8][8], int row, int col, char player){
+    uint64_t black, white;
+    toBitboards(board, black, white);
+    int square = row * 8 + col;
+    return (player == 'b') ? bitboardFlips(black, white, square) : bitboardFlips(white, black, square);
+}
+
+MoveList calculateLegalMoves(char board[8][8], char player) {
+    return (player == 'b') ? calculateLegalMoves<'b'>(board) : calculateLegalMoves<'w'>(board);
+}
+
+bool isLegalMove(char board[8][8], const MoveList & move_list, int row, int col, char player) {
+
+    //This error should NOT occur, as the regex pattern validates the user's input
+    if(row > 7 || row < 0 || col > 7 || col < 0)
+        throw std::range_error{"isLegalMove()"};
+
+    // Make sure position is empty
+    if(board[row][col] != '-'){
+        return false;
+    }
+
+    if (move_list.contains(row * 8 + col)){
+        return true;
+    }
+
+    return false;
+}
+
+MoveList getBlackLegalMoves(char board[8][8]) {
+    return calculateLegalMoves(board, 'b');
+}
+
+MoveList getWhiteLegalMoves(char board[8][8]) {
+    return calculateLegalMoves(board, 'w');
+}
+
+void printLegalMoves(char board[8][8], char player){
+    if(player == 'b'){
+        std::cout << "Black legal moves:\n";
+        auto v = getBlackLegalMoves(board);
+        for ( int square : v ) {
+            std::cout << "(" << square / 8  << "," << square % 8 << ")  ";
+        }
+        std::cout << std::endl;
+    } else {
+        std::cout << "White legal moves:\n";
+        auto x = getWhiteLegalMoves(board);
+        for ( int square : x ) {
+            std::cout << "(" << square / 8  << "," << square % 8 << ")  ";
+        }
+        std::cout << std::endl;
+    }
+}
+
+void printLegalMoves(const MoveList & move_list){
+    for ( int square : move_list ){
+        std::cout << "(" << square / 8  << "," << square % 8 << ")  ";
+    }
+    std::cout << std::endl;
+}
+
+std::ostream& operator<<(std::ostream& os, const char board[8][8]){
+    std::cout << "   0  1  2  3  4  5  6  7\n";
+    for(int i = 0; i < 8; ++i){
+        std::cout << (i) << "  ";
+        for (int j = 0; j < 8; ++j) {
+            std::cout << board[i][j] << "  ";
+        }
+        std::cout << '\n';
+    }
+    return os;
+}
+
+bool isGameOver(char board[8][8]){
+    return getBlackLegalMoves(board).empty() && getWhiteLegalMoves(board).empty();
+}
+
+int getScore(char board[8][8], char player){
+    int total = 0;
+    for(int i = 0; i < 8; ++i)
+        for(int j = 0; j < 8; ++j)
+            if(board[i][j] == player)
+                total += 1;
+
+    return total;
+}
+
+void printWinner(char (&board)[8][8]){
+    int white_total = getScore(board, 'w');
+    int black_total = getScore(board, 'b');
+
+    std::cout << "Black total: " << black_total << '\n';
+    std::cout << "White total: " << white_total << '\n';
+    if(black_total == white_total){
+        std::cout << "TIE GAME\n";
+        return;
+    }
+
+    std::cout << ((black_total > white_total) ? "Black" : "White") << " wins!\n";
+}
+
+void toBitboards(char board[8][8], uint64_t & black, uint64_t & white){
+    black = 0;
+    white = 0;
+    for(int i = 0; i < 8; ++i){
+        for(int j = 0; j < 8; ++j){
+            if(board[i][j] == 'b')
+                black |= uint64_t(1) << (i * 8 + j);
+            else if(board[i][j] == 'w')
+                white |= uint64_t(1) << (i * 8 + j);
+        }
+    }
+}
+
+void fromBitboards(uint64_t black, uint64_t white, char (&board)[8][8]){
+    for(int i = 0; i < 8; ++i){
+        for(int j = 0; j < 8; ++j){
+            uint64_t bit = uint64_t(1) << (i * 8 + j);
+            board[i][j] = (black & bit) ? 'b' : (white & bit) ? 'w' : '-';
+        }
+    }
+}
+
+void initializeBoard(char (&board)[8][8]){
+    for(auto & i : board){
+        for (char & j : i) {
+            j = '-';
+        }
+    }
+
+    board[3][3] = 'w'; board[3][4] = 'b';
+    board[4][3] = 'b'; board[4][4] = 'w';
+}
+
+std::string squareName(int row, int col){
+    return std::string{static_cast<char>('a' + col), static_cast<char>('1' + row)};
+}
+
+bool parseSquare(const std::string & name, int & row, int & col){
+    if(name.size() != 2)
+        return false;
+
+    char letter = static_cast<char>(std::tolower(static_cast<unsigned char>(name[0])));
+    if(letter < 'a' || letter > 'h' || name[1] < '1' || name[1] > '8')
+        return false;
+
+    row = name[1] - '1';
+    col = letter - 'a';
+    return true;
+}
+
+uint64_t mixBits(uint64_t x){
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t hashPosition(uint64_t black, uint64_t white, char player){
+    return mixBits(mixBits(black) ^ white ^ ((player == 'w') ? 0x9e3779b97f4a7c15ULL : 0));
+}
+
+uint64_t hashPosition(char board[8][8], char player){
+    uint64_t black, white;
+    toBitboards(board, black, white);
+    return hashPosition(black, white, player);
+}
+
+uint64_t flipVertical(uint64_t x){
+    return __builtin_bswap64(x);
+}
+
+uint64_t mirrorHorizontal(uint64_t x){
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((x & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    return x;
+}
+
+uint64_t transposeBitboard(uint64_t x){
+    uint64_t t;
+    t = 0x0f0f0f0f00000000ULL & (x ^ (x << 28));
+    x ^= t ^ (t >> 28);
+    t = 0x3333000033330000ULL & (x ^ (x << 14));
+    x ^= t ^ (t >> 14);
+    t = 0x5500550055005500ULL & (x ^ (x << 7));
+    x ^= t ^ (t >> 7);
+    return x;
+}
+
+uint64_t transformBitboard(uint64_t x, int transform){
+    if(transform & 4)
+        x = transposeBitboard(x);
+    if(transform & 2)
+        x = flipVertical(x);
+    if(transform & 1)
+        x = mirrorHorizontal(x);
+    return x;
+}
+
+int transformSquare(int square, int transform){
+    int row = square / 8, col = square % 8;
+    if(transform & 4)
+        std::swap(row, col);
+    if(transform & 2)
+        row = 7 - row;
+    if(transform & 1)
+        col = 7 - col;
+    return row * 8 + col;
+}
+
+int untransformSquare(int square, int transform){
+    int row = square / 8, col = square % 8;
+    if(transform & 1)
+        col = 7 - col;
+    if(transform & 2)
+        row = 7 - row;
+    if(transform & 4)
+        std::swap(row, col);
+    return row * 8 + col;
+}
+
+int canonicalize(uint64_t & black, uint64_t & white){
+    uint64_t best_black = black, best_white = white;
+    int best_transform = 0;
+    for(int transform = 1; transform < 8; ++transform){
+        uint64_t b = transformBitboard(black, transform);
+        uint64_t w = transformBitboard(white, transform);
+        if(b < best_black || (b == best_black && w < best_white)){
+            best_black = b;
+            best_white = w;
+            best_transform = transform;
+        }
+    }
+
+    black = best_black;
+    white = best_white;
+    return best_transform;
+}
+
+uint64_t canonicalHash(char board[8][8], char player, int & transform){
+    uint64_t black, white;
+    toBitboards(board, black, white);
+    transform = canonicalize(black, white);
+    return hashPosition(black, white, player);
+}
+
+int emptySquares(char board[8][8]){
+    return 64 - getScore(board, 'b') - getScore(board, 'w');
+}
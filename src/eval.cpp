@@ -0,0 +1,45 @@
+#include "othello/eval.h"
+
+int heuristic(char board[8][8], const EvalWeights & weights){
+
+    // intialize black and white total
+    int b_total = 0;
+    int w_total = 0;
+
+    // factor in the amount of moves each player has
+    b_total += weights.mobility * static_cast<int>(getBlackLegalMoves(board).size());
+    w_total += weights.mobility * static_cast<int>(getWhiteLegalMoves(board).size());
+
+    // factor in the amount of pieces each player has on the board
+    b_total += weights.disc * getScore(board, 'b');
+    w_total += weights.disc * getScore(board, 'w');
+
+    // factor in the importance of all 4 corners
+    if(board[0][0] == 'w'){
+        w_total += weights.corner;
+    }
+    if(board[0][0] == 'b'){
+        b_total += weights.corner;
+    }
+    if(board[7][0] == 'w'){
+        w_total += weights.corner;
+    }
+    if(board[7][0] == 'b'){
+        b_total += weights.corner;
+    }
+    if(board[0][7] == 'w'){
+        w_total += weights.corner;
+    }
+    if(board[0][7] == 'b'){
+        b_total += weights.corner;
+    }
+    if(board[7][7] == 'w'){
+        w_total += weights.corner;
+    }
+    if(board[7][7] == 'b'){
+        b_total += weights.corner;
+    }
+
+    // subtract white's total from black, let black be the maximizer
+    return (b_total-w_total);
+}
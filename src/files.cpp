@@ -0,0 +1,244 @@
+#include "othello/files.h"
+
+#include <cctype>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::open(const std::string & path){
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0){
+        ::close(fd);
+        return false;
+    }
+
+    size_ = static_cast<std::size_t>(info.st_size);
+    if(size_ > 0){
+        void * mapping = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED){
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const unsigned char *>(mapping);
+    }
+
+    ::close(fd); // the mapping stays valid after the descriptor is closed
+    return true;
+}
+
+void MappedFile::close(){
+    if(data_ != NULL)
+        munmap(const_cast<unsigned char *>(data_), size_);
+    data_ = NULL;
+    size_ = 0;
+}
+
+bool OpeningBook::open(const std::string & path){
+    entries_ = NULL;
+    count_ = 0;
+    if(!file_.open(path))
+        return false;
+
+    if(file_.size() < sizeof(BookHeader)){
+        file_.close();
+        return false;
+    }
+
+    BookHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if(std::memcmp(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0
+       || header.count > (file_.size() - sizeof(BookHeader)) / sizeof(BookEntry)){ // no overflow for a bad count
+        file_.close();
+        return false;
+    }
+
+    entries_ = reinterpret_cast<const BookEntry *>(file_.data() + sizeof(BookHeader));
+    count_ = header.count;
+    madvise(const_cast<unsigned char *>(file_.data()), file_.size(), MADV_RANDOM);
+    return true;
+}
+
+uint8_t probeBook(const OpeningBook & book, char board[8][8], char player){
+    int transform;
+    const BookEntry * entry = book.find(canonicalHash(board, player, transform));
+    if(entry == NULL || entry->move >= 64)
+        return NO_MOVE;
+
+    // the stored move belongs to the canonical board, map it back onto this one
+    int square = untransformSquare(entry->move, transform);
+    int row = square / 8;
+    int col = square % 8;
+
+    // guard against hash collisions (and stale books) by making sure the stored move is playable here
+    if(board[row][col] != '-' || !isFlippable(board, row, col, player))
+        return NO_MOVE;
+
+    return static_cast<uint8_t>(square);
+}
+
+bool packPosition(char board[8][8], char player, PackedPosition & packed){
+    if(board[3][3] == '-')
+        return false;
+
+    toBitboards(board, packed.black, packed.white);
+    packed.white = (packed.white & ~D4_BIT) | ((player == 'w') ? D4_BIT : 0);
+    return true;
+}
+
+void unpackPosition(const PackedPosition & packed, char (&board)[8][8], char & player){
+    player = (packed.white & D4_BIT) ? 'w' : 'b';
+    uint64_t white = (packed.white & ~D4_BIT) | (~packed.black & D4_BIT);
+    for(int i = 0; i < 8; ++i){
+        for(int j = 0; j < 8; ++j){
+            uint64_t bit = uint64_t(1) << (i * 8 + j);
+            board[i][j] = (packed.black & bit) ? 'b' : (white & bit) ? 'w' : '-';
+        }
+    }
+}
+
+std::string positionToText(char board[8][8], char player){
+    std::string text(board[0], board[0] + 64);
+    text += ' ';
+    text += player;
+    return text;
+}
+
+bool positionFromText(const std::string & text, char (&board)[8][8], char & player){
+    if(text.size() < 66 || text[64] != ' ')
+        return false;
+
+    for(int i = 0; i < 64; ++i){
+        char c = text[i];
+        if(c == 'b' || c == 'B' || c == 'X' || c == 'x' || c == '*')
+            board[i / 8][i % 8] = 'b';
+        else if(c == 'w' || c == 'W' || c == 'O' || c == 'o')
+            board[i / 8][i % 8] = 'w';
+        else if(c == '-' || c == '.')
+            board[i / 8][i % 8] = '-';
+        else
+            return false;
+    }
+
+    char side = text[65];
+    if(side == 'b' || side == 'B' || side == 'X' || side == 'x' || side == '*')
+        player = 'b';
+    else if(side == 'w' || side == 'W' || side == 'O' || side == 'o')
+        player = 'w';
+    else
+        return false;
+
+    return true;
+}
+
+bool PositionFileReader::open(const std::string & path){
+    positions_ = NULL;
+    count_ = 0;
+    if(!file_.open(path) || file_.size() < sizeof(RecordFileHeader))
+        return false;
+
+    RecordFileHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if(std::memcmp(header.magic, POSITION_FILE_MAGIC, sizeof(header.magic)) != 0
+       || header.count > (file_.size() - sizeof(RecordFileHeader)) / sizeof(PackedPosition)){
+        file_.close();
+        return false;
+    }
+
+    // the mapping is page aligned and the header is 16 bytes, so the records are properly aligned
+    positions_ = reinterpret_cast<const PackedPosition *>(file_.data() + sizeof(RecordFileHeader));
+    count_ = header.count;
+    madvise(const_cast<unsigned char *>(file_.data()), file_.size(), MADV_SEQUENTIAL);
+    return true;
+}
+
+bool GameFileReader::open(const std::string & path){
+    count_ = 0;
+    read_ = 0;
+    offset_ = sizeof(RecordFileHeader);
+    if(!file_.open(path) || file_.size() < sizeof(RecordFileHeader))
+        return false;
+
+    RecordFileHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if(std::memcmp(header.magic, GAME_FILE_MAGIC, sizeof(header.magic)) != 0){
+        file_.close();
+        return false;
+    }
+
+    count_ = header.count;
+    madvise(const_cast<unsigned char *>(file_.data()), file_.size(), MADV_SEQUENTIAL);
+    return true;
+}
+
+bool recordedMoveIsLegal(char board[8][8], char & player, int row, int col){
+    if(row < 0 || row > 7 || col < 0 || col > 7 || board[row][col] != '-')
+        return false;
+
+    if(isFlippable(board, row, col, player))
+        return true;
+
+    // only a pass can explain a move that isn't playable by the player whose turn it is
+    if(!calculateLegalMoves(board, player).empty())
+        return false;
+
+    player = (player == 'w') ? 'b' : 'w';
+    return isFlippable(board, row, col, player);
+}
+
+bool WthorReader::open(const std::string & path){
+    count_ = 0;
+    if(!file_.open(path) || file_.size() < WTHOR_HEADER_SIZE)
+        return false;
+
+    const unsigned char * header = file_.data();
+    std::size_t games = header[4] | (header[5] << 8) | (header[6] << 16) | (std::size_t(header[7]) << 24);
+    int board_size = header[12];
+    if(board_size != 0 && board_size != 8){ // 10x10 files use a different record layout
+        file_.close();
+        return false;
+    }
+
+    // tolerate truncated downloads by only reading the records that are actually there
+    count_ = std::min(games, (file_.size() - WTHOR_HEADER_SIZE) / WTHOR_GAME_SIZE);
+    year_ = header[10] | (header[11] << 8);
+    madvise(const_cast<unsigned char *>(file_.data()), file_.size(), MADV_SEQUENTIAL);
+    return true;
+}
+
+bool wthorMoves(const WthorGame & game, std::vector<uint8_t> & moves){
+    moves.clear();
+    for(int i = 0; i < 60 && game.moves[i] != 0; ++i){
+        int row = game.moves[i] / 10 - 1;
+        int col = game.moves[i] % 10 - 1;
+        if(row < 0 || row > 7 || col < 0 || col > 7)
+            return false;
+        moves.push_back(static_cast<uint8_t>(row * 8 + col));
+    }
+    return true;
+}
+
+bool parseTranscript(const std::string & line, std::vector<uint8_t> & moves){
+    moves.clear();
+    std::string squares;
+    for(char c : line)
+        if(!std::isspace(static_cast<unsigned char>(c)))
+            squares += c;
+
+    if(squares.size() % 2 != 0)
+        return false;
+
+    for(std::size_t i = 0; i < squares.size(); i += 2){
+        int row, col;
+        if(!parseSquare(squares.substr(i, 2), row, col))
+            return false;
+        moves.push_back(static_cast<uint8_t>(row * 8 + col));
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#include "othello/history.h"
+
+namespace {
+
+// set every square in mask to piece
+void setSquares(char (&board)[8][8], uint64_t mask, char piece){
+    while(mask){
+        int square = __builtin_ctzll(mask);
+        board[square / 8][square % 8] = piece;
+        mask &= mask - 1;
+    }
+}
+
+} // namespace
+
+void GameHistory::play(char (&board)[8][8], int row, int col, char player){
+    // playing the move that was taken back keeps the moves after it for redo
+    if(ply_ < length() && entries_[ply_].square == row * 8 + col && entries_[ply_].player == player){
+        redo(board, player);
+        return;
+    }
+
+    HistoryEntry entry;
+    entry.flips = flipMask(board, row, col, player);
+    entry.square = static_cast<uint8_t>(row * 8 + col);
+    entry.player = player;
+
+    board[row][col] = player;
+    setSquares(board, entry.flips, player);
+
+    entries_.resize(ply_);
+    entries_.push_back(entry);
+    ++ply_;
+}
+
+void GameHistory::pass(char player){
+    if(ply_ < length() && entries_[ply_].square == NO_MOVE && entries_[ply_].player == player){
+        ++ply_;
+        return;
+    }
+
+    HistoryEntry entry;
+    entry.flips = 0;
+    entry.square = NO_MOVE;
+    entry.player = player;
+
+    entries_.resize(ply_);
+    entries_.push_back(entry);
+    ++ply_;
+}
+
+bool GameHistory::undo(char (&board)[8][8], char & player){
+    if(ply_ == 0)
+        return false;
+
+    const HistoryEntry & entry = entries_[--ply_];
+    if(entry.square != NO_MOVE){
+        board[entry.square / 8][entry.square % 8] = '-';
+        setSquares(board, entry.flips, (entry.player == 'w') ? 'b' : 'w');
+    }
+    player = entry.player;
+    return true;
+}
+
+bool GameHistory::redo(char (&board)[8][8], char & player){
+    if(ply_ == length())
+        return false;
+
+    const HistoryEntry & entry = entries_[ply_++];
+    if(entry.square != NO_MOVE){
+        board[entry.square / 8][entry.square % 8] = entry.player;
+        setSquares(board, entry.flips, entry.player);
+    }
+    player = (entry.player == 'w') ? 'b' : 'w';
+    return true;
+}
+
+bool GameHistory::goTo(char (&board)[8][8], char & player, int ply){
+    if(ply < 0 || ply > length())
+        return false;
+
+    while(ply_ > ply)
+        undo(board, player);
+    while(ply_ < ply)
+        redo(board, player);
+    return true;
+}
+
+void GameHistory::clear(){
+    entries_.clear();
+    ply_ = 0;
+}
@@ -0,0 +1,194 @@
+#include "othello/othello_c.h"
+#include "othello/othello.h"
+
+#include <exception>
+#include <memory>
+#include <new>
+
+struct othello_engine
+{
+    EngineConfig config;
+    std::unique_ptr<TranspositionTable> tt;
+    char board[8][8];
+    char player = 'b';
+    std::atomic<bool> stop{false};
+    SearchResult result;
+    int sign = 1; // turns the black-view scores of result into scores of the player that was searched for
+    std::string error;
+};
+
+namespace {
+
+// square number of a move for the C interface, OTHELLO_PASS for NO_MOVE
+int squareOf(uint8_t move){
+    return (move == NO_MOVE) ? OTHELLO_PASS : move;
+}
+
+// a new position is a new move of the game, age the table once for it (and not for every search)
+void newMove(othello_engine * engine){
+    if(engine->tt)
+        engine->tt->newSearch();
+}
+
+int fail(othello_engine * engine, const std::string & message){
+    engine->error = message;
+    return OTHELLO_ERROR;
+}
+
+}
+
+othello_engine * othello_engine_new(void){
+    try{
+        // owned here until it is complete, a table that cannot be allocated must not leak the engine
+        std::unique_ptr<othello_engine> engine(new othello_engine);
+        engine->config.tt_megabytes = TT_MEGABYTES;
+        engine->tt.reset(new TranspositionTable(TT_MEGABYTES));
+        engine->config.tt = engine->tt.get();
+        initializeBoard(engine->board);
+        return engine.release();
+    } catch(const std::exception &){
+        return NULL;
+    }
+}
+
+void othello_engine_free(othello_engine * engine){
+    delete engine;
+}
+
+const char * othello_last_error(const othello_engine * engine){
+    return engine->error.c_str();
+}
+
+int othello_configure(othello_engine * engine, const char * config){
+    engine->error.clear();
+    if(config == NULL)
+        return fail(engine, "config must not be NULL");
+    try{
+        // the engine keeps a table unless the description turns it off with tt=0
+        EngineConfig parsed = parseEngineConfig("tt=" + std::to_string(TT_MEGABYTES) + (*config ? "," : "") + config);
+        engine->tt.reset();
+        if(parsed.tt_megabytes > 0)
+            engine->tt.reset(new TranspositionTable(parsed.tt_megabytes));
+        parsed.tt = engine->tt.get();
+        engine->config = parsed;
+        return OTHELLO_OK;
+    } catch(const std::exception & e){
+        return fail(engine, e.what());
+    }
+}
+
+int othello_set_position(othello_engine * engine, const char * position){
+    engine->error.clear();
+    if(position == NULL)
+        return fail(engine, "position must not be NULL");
+    std::string text = position;
+    if(text == "startpos"){
+        initializeBoard(engine->board);
+        engine->player = 'b';
+        newMove(engine);
+        return OTHELLO_OK;
+    }
+
+    char board[8][8];
+    char player;
+    if(!positionFromText(text, board, player))
+        return fail(engine, "invalid position \"" + text + "\"");
+    std::memcpy(engine->board, board, 8 * 8 * sizeof(char));
+    engine->player = player;
+    newMove(engine);
+    return OTHELLO_OK;
+}
+
+int othello_play(othello_engine * engine, int square){
+    engine->error.clear();
+    char other_player = (engine->player == 'w') ? 'b' : 'w';
+    if(square == OTHELLO_PASS){
+        if(!calculateLegalMoves(engine->board, engine->player).empty())
+            return fail(engine, "pass with legal moves available");
+        engine->player = other_player;
+        newMove(engine);
+        return OTHELLO_OK;
+    }
+
+    if(square < 0 || square > 63)
+        return fail(engine, "square " + std::to_string(square) + " is off the board");
+    int row = square / 8, col = square % 8;
+    char player = engine->player;
+    if(!recordedMoveIsLegal(engine->board, player, row, col))
+        return fail(engine, "illegal move " + squareName(row, col));
+    makeMove(engine->board, row, col, player);
+    engine->player = (player == 'w') ? 'b' : 'w';
+    newMove(engine);
+    return OTHELLO_OK;
+}
+
+int othello_side_to_move(const othello_engine * engine){
+    return engine->player;
+}
+
+int othello_legal_moves(const othello_engine * engine, int * squares, int capacity){
+    char board[8][8];
+    std::memcpy(board, engine->board, 8 * 8 * sizeof(char));
+    MoveList move_list = calculateLegalMoves(board, engine->player);
+    for(int i = 0; i < move_list.size() && i < capacity; ++i)
+        squares[i] = move_list.squares[i];
+    return move_list.size();
+}
+
+int othello_search(othello_engine * engine, int depth, int time_ms, othello_progress_callback callback,
+                   void * user_data){
+    engine->error.clear();
+    if(depth < 1 || depth > 60 || time_ms < 0)
+        return fail(engine, "depth must be 1-60 and time_ms at least 0");
+
+    SearchLimits limits;
+    limits.depth = depth;
+    limits.time_ms = time_ms;
+    engine->sign = (engine->player == 'b') ? 1 : -1;
+    try{
+        engine->result = search(engine->board, engine->player, limits, engine->config, engine->stop,
+                                [&](const SearchResult & iteration){
+            if(callback == NULL)
+                return;
+            othello_progress progress;
+            progress.depth = iteration.depth;
+            progress.score = engine->sign * iteration.score;
+            progress.best_move = squareOf(iteration.move);
+            progress.nodes = iteration.nodes;
+            progress.seconds = iteration.seconds;
+            if(callback(&progress, user_data) != 0)
+                engine->stop = true;
+        });
+        // cleared once the search is over rather than when the next one starts, so that a stop requested before
+        // othello_search() was entered is not lost
+        engine->stop = false;
+        return OTHELLO_OK;
+    } catch(const std::exception & e){
+        engine->stop = false;
+        engine->result = SearchResult();
+        return fail(engine, e.what());
+    }
+}
+
+void othello_stop(othello_engine * engine){
+    engine->stop = true;
+}
+
+int othello_best_move(const othello_engine * engine){
+    return squareOf(engine->result.move);
+}
+
+int othello_score(const othello_engine * engine){
+    return engine->sign * engine->result.score;
+}
+
+int othello_depth(const othello_engine * engine){
+    return engine->result.depth;
+}
+
+int othello_pv(const othello_engine * engine, int * squares, int capacity){
+    const Line & pv = engine->result.pv;
+    for(int i = 0; i < pv.length && i < capacity; ++i)
+        squares[i] = squareOf(pv.moves[i]);
+    return pv.length;
+}
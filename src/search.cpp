@@ -0,0 +1,1016 @@
+#include "othello/search.h"
+#include "othello/files.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+GameTree::GameTree(char board[8][8], int depth, char player){
+    std::vector<Node> nodes(1);
+    toBitboards(board, nodes[0].black, nodes[0].white);
+    nodes[0].move = NO_MOVE;
+    build(nodes, 0, depth, player);
+
+    std::size_t bytes = (nodes.size() * sizeof(Node) + 63) / 64 * 64;
+    nodes_ = static_cast<Node *>(std::aligned_alloc(64, bytes));
+    if(nodes_ == NULL)
+        throw std::bad_alloc{};
+    std::memcpy(nodes_, nodes.data(), nodes.size() * sizeof(Node));
+    size_ = nodes.size();
+}
+
+void GameTree::build(std::vector<Node> & nodes, std::size_t index, int depth, char player){
+    if(depth == 0)
+        return;
+
+    char board[8][8];
+    fromBitboards(nodes[index].black, nodes[index].white, board);
+    char other_player = (player == 'w') ? 'b' : 'w';
+    MoveList move_list = calculateLegalMoves(board, player);
+    if(move_list.empty() && calculateLegalMoves(board, other_player).empty())
+        return; // game over
+
+    int count = move_list.empty() ? 1 : move_list.size();
+    uint32_t first = static_cast<uint32_t>(nodes.size());
+    nodes.resize(nodes.size() + count);
+    nodes[index].first_child = first;
+    nodes[index].child_count = static_cast<uint8_t>(count);
+    for(int i = 0; i < count; ++i){
+        Node & child = nodes[first + i];
+        if(move_list.empty()){
+            child.black = nodes[index].black;
+            child.white = nodes[index].white;
+            child.move = NO_MOVE;
+            continue;
+        }
+
+        // must make the associating move first so a subtree of 'that' board configuration can be created
+        char tmp_board[8][8];
+        std::memcpy(tmp_board, board, 8 * 8 * sizeof(char));
+        makeMove(tmp_board, move_list.row(i), move_list.col(i), player);
+        toBitboards(tmp_board, child.black, child.white);
+        child.move = move_list.squares[i];
+    }
+
+    for(int i = 0; i < count; ++i)
+        build(nodes, first + i, depth - 1, other_player);
+}
+
+int16_t packScore(int score){
+    return static_cast<int16_t>(std::min(std::max(score, -32768), 32767));
+}
+
+int heuristic(const Node & node, const EvalWeights & weights){
+    char board[8][8];
+    fromBitboards(node.black, node.white, board);
+    return heuristic(board, weights);
+}
+
+int minimax(GameTree & tree, Node & position, int depth, bool maximizing_player, Line & pv,
+            const EvalWeights & weights){
+    //std::cout << "DEPTH = " << depth << '\n';
+    pv.length = 0;
+    if(depth == 0 || position.child_count == 0){
+        //std::cout<< "returning heursitic: " << heuristic(position) << '\n';
+        return heuristic(position, weights);
+    }
+
+    Line child_pv;
+
+    if(maximizing_player){
+        int max_eval = -9999999;
+        for(int i = 0; i < position.child_count; ++i){
+            Node & child = tree.child(position, i);
+            int eval = minimax(tree, child, depth - 1, false, child_pv, weights);
+            if(eval > max_eval){
+                max_eval = eval;
+                pv.set(child.move, child_pv);
+            }
+        }
+        position.val = packScore(max_eval);
+        return max_eval;
+    } else {
+        int min_eval = 9999999;
+        for(int i = 0; i < position.child_count; ++i){
+            Node & child = tree.child(position, i);
+            int eval = minimax(tree, child, depth -1, true, child_pv, weights);
+            if(eval < min_eval){
+                min_eval = eval;
+                pv.set(child.move, child_pv);
+            }
+        }
+        position.val = packScore(min_eval);
+        return min_eval;
+    }
+}
+
+// state shared by all nodes of one search
+struct SearchContext
+{
+    const EngineConfig * config;
+    const std::atomic<bool> * stop; // set by another thread to end the search early
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point deadline;
+    bool has_deadline = false;
+    long long nodes = 0;
+    long long etc_cutoffs = 0;
+    bool aborted = false; // the current iteration was cut short and its result must be discarded
+};
+
+// models per stage and depth, fitted by "othello probcut --positions 300 --depth 8" (which prints this table)
+const ProbCutModel PROBCUT_MODELS[PROBCUT_STAGES][PROBCUT_DEPTHS] = {
+    {{0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {0.896, 1.04, 2.67}, {0.976, -0.32, 1.98}, {0.888, 1.17, 3.29}, {0.962, -0.66, 2.49}, {0.989, 0.39, 2.30}, {0.981, -0.42, 2.46}},
+    {{0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {0.999, 0.59, 3.56}, {0.998, 0.15, 3.44}, {1.011, 0.75, 5.87}, {1.042, 0.74, 5.43}, {1.113, 0.09, 5.03}, {1.150, 1.24, 4.33}},
+    {{0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {1.088, 0.03, 3.86}, {1.071, 0.51, 3.11}, {1.158, -0.21, 5.44}, {1.152, 0.63, 5.15}, {1.156, -0.49, 4.39}, {1.140, 0.65, 4.42}},
+    {{0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {0.000, 0.00, 0.00}, {1.028, 0.02, 4.95}, {1.056, 0.71, 5.56}, {1.096, -0.32, 8.45}, {1.127, 1.36, 9.02}, {1.138, -0.78, 8.50}, {1.104, 2.03, 7.86}},
+};
+
+int probCutDepth(int depth){
+    int shallow = depth / 2;
+    if((depth - shallow) % 2 != 0)
+        shallow -= 1;
+    return std::max(shallow, 1);
+}
+
+int probCutStage(const char board[8][8]){
+    int discs = 0;
+    for(int i = 0; i < 8; ++i)
+        for(int j = 0; j < 8; ++j)
+            discs += (board[i][j] != '-');
+    return std::min((discs - 4) / 15, PROBCUT_STAGES - 1);
+}
+
+const ProbCutModel & probCutModel(const char board[8][8], int depth){
+    static const ProbCutModel none = {0, 0, 0};
+    int stage = probCutStage(board);
+    // depths without a model of their own (deeper than the table, or not fitted) use the next shallower depth of
+    // the same parity that has one, the shallow search then predicts further ahead than the model was fitted for
+    for(; depth >= PROBCUT_MIN_DEPTH; depth -= 2){
+        if(depth < PROBCUT_DEPTHS && PROBCUT_MODELS[stage][depth].a > 0)
+            return PROBCUT_MODELS[stage][depth];
+    }
+    return none;
+}
+
+// checked every few nodes so that a stop request or the time limit ends the search promptly
+bool searchShouldStop(SearchContext & ctx){
+    if(!ctx.aborted && (ctx.nodes & 1023) == 0){
+        if(ctx.stop->load(std::memory_order_relaxed)
+           || (ctx.has_deadline && std::chrono::steady_clock::now() >= ctx.deadline))
+            ctx.aborted = true;
+    }
+    return ctx.aborted;
+}
+
+// depth-first minimax with alpha-beta pruning that works on copies of the board instead of a prebuilt game tree
+// black is the maximizing player, a player without moves passes and two passes in a row end the game
+// compiled once per side to move, so that nothing in a node tests which side that is
+template<bool MAXIMIZING>
+int alphaBeta(char board[8][8], int depth, int alpha, int beta, SearchContext & ctx){
+    ctx.nodes += 1;
+    if(searchShouldStop(ctx))
+        return 0;
+
+    if(depth == 0)
+        return heuristic(board, ctx.config->weights);
+
+    constexpr bool maximizing_player = MAXIMIZING;
+    constexpr char player = MAXIMIZING ? 'b' : 'w';
+    constexpr char opponent = MAXIMIZING ? 'w' : 'b';
+
+    // a previous search of this position may already answer the question, or at least know a good first move
+    TranspositionTable * tt = ctx.config->tt;
+    uint64_t key = 0;
+    int tt_move = -1;
+    if(tt != NULL){
+        key = hashPosition(board, player);
+        TTEntry entry;
+        if(tt->probe(key, entry)){
+            tt_move = entry.move;
+            if(entry.depth >= depth){
+                if(entry.bound == TT_EXACT)
+                    return entry.score;
+                if(entry.bound == TT_LOWER)
+                    alpha = std::max(alpha, entry.score);
+                else
+                    beta = std::min(beta, entry.score);
+                if(beta <= alpha)
+                    return entry.score;
+            }
+        }
+    }
+    const int window_alpha = alpha, window_beta = beta;
+
+    // multi-probcut: when a shallow search lands far enough outside the window, the deep search is predicted to
+    // land outside it as well and is skipped; how far is ctx.config->probcut standard deviations of the model's error
+    if(ctx.config->probcut > 0 && depth >= PROBCUT_MIN_DEPTH && alpha > -9999999 && beta < 9999999){
+        const ProbCutModel & model = probCutModel(board, depth);
+        if(model.a > 0){
+            int shallow = probCutDepth(depth);
+            double margin = ctx.config->probcut * model.sigma;
+            double offset = maximizing_player ? model.b : -model.b;
+            int bound = static_cast<int>(std::ceil((beta + margin - offset) / model.a));
+            if(alphaBeta<MAXIMIZING>(board, shallow, bound - 1, bound, ctx) >= bound)
+                return beta;
+            bound = static_cast<int>(std::floor((alpha - margin - offset) / model.a));
+            if(alphaBeta<MAXIMIZING>(board, shallow, bound, bound + 1, ctx) <= bound)
+                return alpha;
+        }
+    }
+
+    MoveList move_list = calculateLegalMoves<player>(board);
+    if(move_list.empty()){
+        // if neither player can move the game is over, otherwise pass the turn to the other player
+        if(calculateLegalMoves<opponent>(board).empty())
+            return heuristic(board, ctx.config->weights);
+        return alphaBeta<!MAXIMIZING>(board, depth - 1, alpha, beta, ctx);
+    }
+
+    // try the table's move first
+    if(tt_move >= 0)
+        move_list.moveSquareToFront(tt_move);
+
+    // enhanced transposition cutoff: when the table already proves one child refutes the window there is no need
+    // to search any of them; probing every child is cheap next to the subtrees of a deep enough search
+    if(tt != NULL && ctx.config->etc_depth > 0 && depth >= ctx.config->etc_depth){
+        for(int square : move_list){
+            char child[8][8];
+            std::memcpy(child, board, 8 * 8 * sizeof(char));
+            makeMove<player>(child, square / 8, square % 8);
+
+            TTEntry entry;
+            if(!tt->probe(hashPosition(child, opponent), entry) || entry.depth < depth - 1)
+                continue;
+            if(maximizing_player ? (entry.bound != TT_UPPER && entry.score >= beta)
+                                 : (entry.bound != TT_LOWER && entry.score <= alpha)){
+                ctx.etc_cutoffs += 1;
+                tt->store(key, entry.score, depth, maximizing_player ? TT_LOWER : TT_UPPER, square);
+                return entry.score;
+            }
+        }
+    }
+
+    int best = maximizing_player ? -9999999 : 9999999;
+    int best_move = -1;
+    for(int square : move_list){
+        char child[8][8];
+        std::memcpy(child, board, 8 * 8 * sizeof(char));
+        makeMove<player>(child, square / 8, square % 8);
+
+        int eval = alphaBeta<!MAXIMIZING>(child, depth - 1, alpha, beta, ctx);
+        if(maximizing_player ? eval > best : eval < best){
+            best = eval;
+            best_move = square;
+        }
+        if(maximizing_player)
+            alpha = std::max(alpha, eval);
+        else
+            beta = std::min(beta, eval);
+
+        if(beta <= alpha)
+            break;
+    }
+
+    if(tt != NULL && !ctx.aborted){
+        int bound = (best <= window_alpha) ? TT_UPPER : (best >= window_beta) ? TT_LOWER : TT_EXACT;
+        tt->store(key, best, depth, bound, best_move);
+    }
+    return best;
+}
+
+int alphaBeta(char board[8][8], int depth, int alpha, int beta, bool maximizing_player, SearchContext & ctx){
+    if(maximizing_player)
+        return alphaBeta<true>(board, depth, alpha, beta, ctx);
+    return alphaBeta<false>(board, depth, alpha, beta, ctx);
+}
+
+// one iteration of search(): the value of the root within (alpha, beta), best_index receives the position of the
+// best move in move_list; a value <= alpha or >= beta is only a bound, like in alphaBeta()
+int searchRoot(char board[8][8], char player, const MoveList & move_list, int depth,
+               int alpha, int beta, SearchContext & ctx, int & best_index){
+    bool maximizing_player = (player == 'b');
+    int best_score = maximizing_player ? -9999999 : 9999999;
+    best_index = 0;
+    for(int i = 0; i < move_list.size(); ++i){
+        char child[8][8];
+        std::memcpy(child, board, 8 * 8 * sizeof(char));
+        makeMove(child, move_list.row(i), move_list.col(i), player);
+
+        int eval = alphaBeta(child, depth - 1, alpha, beta, !maximizing_player, ctx);
+        if(ctx.aborted)
+            break;
+
+        if(maximizing_player ? eval > best_score : eval < best_score){
+            best_score = eval;
+            best_index = i;
+        }
+        if(maximizing_player)
+            alpha = std::max(alpha, eval);
+        else
+            beta = std::min(beta, eval);
+
+        if(beta <= alpha)
+            break;
+    }
+    return best_score;
+}
+
+// MTD(f): closes in on the value of the root with null-window searches, starting from guess; every search tells
+// whether the value is below or above its window, and the transposition table keeps the re-searches cheap
+// the best move is rotated to the front of move_list
+int mtdf(char board[8][8], char player, MoveList & move_list, int depth, int guess,
+         SearchContext & ctx){
+    bool maximizing_player = (player == 'b');
+    int lower = -99999999, upper = 99999999;
+    int value = guess;
+    while(lower < upper){
+        int beta = (value == lower) ? value + 1 : value;
+        int best_index = 0;
+        value = searchRoot(board, player, move_list, depth, beta - 1, beta, ctx, best_index);
+        if(ctx.aborted)
+            break;
+
+        if(value < beta)
+            upper = value;
+        else
+            lower = value;
+
+        // a search failing in the side to move's favor has found a move at least as good as its value
+        if(maximizing_player == (value >= beta))
+            move_list.moveToFront(best_index);
+    }
+    return value;
+}
+
+// the endgame solver works on bitboards (see toBitboards()) from the point of view of the player to move, own
+// being that player's discs and opp the opponent's; its values are final disc differences (own - opp)
+
+const uint64_t BORDER = 0xff818181818181ffULL;
+
+// squares where the player owning own may move
+uint64_t bitboardMoves(uint64_t own, uint64_t opp){
+    uint64_t empty = ~(own | opp);
+    uint64_t moves = 0;
+    for(int direction = 0; direction < 8; ++direction){
+        // runs of opponent discs next to own discs, then the empty square behind them
+        uint64_t x = shiftBitboard(own, direction) & opp;
+        for(int i = 0; i < 5; ++i)
+            x |= shiftBitboard(x, direction) & opp;
+        moves |= shiftBitboard(x, direction) & empty;
+    }
+    return moves;
+}
+
+// squares whose line in each direction pair (0 horizontal, 1 vertical, 2 and 3 diagonal) is completely filled
+void fullLines(uint64_t filled, uint64_t (&full)[4]){
+    for(int axis = 0; axis < 4; ++axis){
+        // a square's line is full when the squares reachable in both directions all are
+        uint64_t line = filled;
+        for(int direction = 2 * axis; direction < 2 * axis + 2; ++direction){
+            uint64_t reach = ~filled;
+            for(int i = 0; i < 7; ++i)
+                reach |= shiftBitboard(reach, direction ^ 1) & filled;
+            line &= ~reach;
+        }
+        full[axis] = line;
+    }
+}
+
+// lower bound on the discs of own that can never be flipped: a disc is stable when along each of the four axes its
+// line is full or one of its neighbors is the board's edge or a stable disc of the same color
+uint64_t stableDiscs(uint64_t own, uint64_t opp){
+    uint64_t full[4];
+    fullLines(own | opp, full);
+
+    const uint64_t edges[4] = {~(NOT_COL_A & NOT_COL_H), 0xff000000000000ffULL, BORDER, BORDER};
+    uint64_t stable = 0;
+    while(true){
+        uint64_t next = own;
+        for(int axis = 0; axis < 4; ++axis)
+            next &= full[axis] | edges[axis] | shiftBitboard(stable, 2 * axis) | shiftBitboard(stable, 2 * axis + 1);
+        if(next == stable)
+            return stable;
+        stable = next;
+    }
+}
+
+// solveEndgame() for exactly EMPTIES empty squares: the number of empties is a compile time constant, so the
+// compiler unrolls the loop over them and the recursion down to the end of the game; too few moves remain for
+// move ordering or stability checks to pay off
+template<int EMPTIES>
+int solveLast(uint64_t own, uint64_t opp, int alpha, int beta, bool passed, SearchContext & ctx){
+    ctx.nodes += 1;
+    uint64_t empty = ~(own | opp);
+    int best = -65; // stays below any score while no move has been found
+    for(int i = 0; i < EMPTIES; ++i, empty &= empty - 1){
+        int square = __builtin_ctzll(empty);
+        uint64_t flipped = bitboardFlips(own, opp, square);
+        if(flipped == 0)
+            continue;
+
+        int score = -solveLast<EMPTIES - 1>(opp & ~flipped, own | flipped | (uint64_t(1) << square), -beta, -alpha, false, ctx);
+        if(score > best){
+            best = score;
+            alpha = std::max(alpha, score);
+            if(alpha >= beta)
+                break;
+        }
+    }
+
+    if(best == -65){
+        if(passed) // neither player can move, the game is over
+            return __builtin_popcountll(own) - __builtin_popcountll(opp);
+        return -solveLast<EMPTIES>(opp, own, -beta, -alpha, true, ctx);
+    }
+    return best;
+}
+
+// a full board, the game is over
+template<>
+int solveLast<0>(uint64_t own, uint64_t opp, int, int, bool, SearchContext & ctx){
+    ctx.nodes += 1;
+    return __builtin_popcountll(own) - __builtin_popcountll(opp);
+}
+
+const int SOLVER_TT_EMPTIES = 7; // fewest empty squares at which the solver uses the transposition table
+
+// key of a solver position in the transposition table: the solver's values are final disc differences instead of
+// heuristic() values, so its entries are kept apart from the search's (and don't depend on the color to move)
+uint64_t solverKey(uint64_t own, uint64_t opp){
+    return hashPosition(own, opp, 'b') ^ 0x2545f4914f6cdd1dULL;
+}
+
+// exact final disc difference of the position within (alpha, beta), a value <= alpha or >= beta is only a bound;
+// passed is set when the opponent just passed
+int solveEndgame(uint64_t own, uint64_t opp, int alpha, int beta, bool passed, SearchContext & ctx){
+    switch(__builtin_popcountll(~(own | opp))){
+        case 0: return solveLast<0>(own, opp, alpha, beta, passed, ctx);
+        case 1: return solveLast<1>(own, opp, alpha, beta, passed, ctx);
+        case 2: return solveLast<2>(own, opp, alpha, beta, passed, ctx);
+        case 3: return solveLast<3>(own, opp, alpha, beta, passed, ctx);
+        case 4: return solveLast<4>(own, opp, alpha, beta, passed, ctx);
+    }
+
+    ctx.nodes += 1;
+    if(searchShouldStop(ctx))
+        return 0;
+
+    // far enough from the end for the table to pay off: an earlier solve may answer the question, or know the
+    // best move
+    int empties = __builtin_popcountll(~(own | opp));
+    TranspositionTable * tt = (empties >= SOLVER_TT_EMPTIES) ? ctx.config->tt : NULL;
+    uint64_t key = 0;
+    int tt_move = -1;
+    if(tt != NULL){
+        key = solverKey(own, opp);
+        TTEntry entry;
+        if(tt->probe(key, entry)){
+            tt_move = entry.move;
+            if(entry.bound == TT_EXACT)
+                return entry.score;
+            if(entry.bound == TT_LOWER)
+                alpha = std::max(alpha, entry.score);
+            else
+                beta = std::min(beta, entry.score);
+            if(alpha >= beta)
+                return entry.score;
+        }
+    }
+    const int window_alpha = alpha, window_beta = beta;
+
+    // the opponent's stable discs cap the best possible result, which may already be no better than alpha
+    // (only worth computing when the opponent has enough discs for the cap to reach alpha)
+    if(64 - 2 * __builtin_popcountll(opp) <= alpha){
+        int best_possible = 64 - 2 * __builtin_popcountll(stableDiscs(opp, own));
+        if(best_possible <= alpha)
+            return best_possible;
+    }
+
+    uint64_t moves = bitboardMoves(own, opp);
+    if(moves == 0){
+        if(passed) // neither player can move, the game is over
+            return __builtin_popcountll(own) - __builtin_popcountll(opp);
+        return -solveEndgame(opp, own, -beta, -alpha, true, ctx);
+    }
+
+    // try the moves leaving the opponent the fewest replies first, unless so few empties remain that sorting
+    // costs more than it saves
+    int squares[MAX_MOVES];
+    int count = 0;
+    for(; moves != 0; moves &= moves - 1)
+        squares[count++] = __builtin_ctzll(moves);
+    if(empties > 6){
+        int replies[MAX_MOVES];
+        for(int i = 0; i < count; ++i){
+            uint64_t flipped = bitboardFlips(own, opp, squares[i]);
+            replies[i] = __builtin_popcountll(bitboardMoves(opp & ~flipped, own | flipped | (uint64_t(1) << squares[i])));
+        }
+        for(int i = 1; i < count; ++i){
+            for(int j = i; j > 0 && replies[j] < replies[j - 1]; --j){
+                std::swap(replies[j], replies[j - 1]);
+                std::swap(squares[j], squares[j - 1]);
+            }
+        }
+    }
+
+    // the table's move goes first
+    for(int i = 1; i < count && tt_move >= 0; ++i){
+        if(squares[i] == tt_move){
+            std::rotate(squares, squares + i, squares + i + 1);
+            break;
+        }
+    }
+
+    int best = -64;
+    int best_move = squares[0];
+    for(int i = 0; i < count; ++i){
+        uint64_t flipped = bitboardFlips(own, opp, squares[i]);
+        int score = -solveEndgame(opp & ~flipped, own | flipped | (uint64_t(1) << squares[i]), -beta, -alpha, false, ctx);
+        if(score > best){
+            best = score;
+            best_move = squares[i];
+            alpha = std::max(alpha, score);
+            if(alpha >= beta)
+                break;
+        }
+    }
+
+    if(tt != NULL && !ctx.aborted){
+        int bound = (best <= window_alpha) ? TT_UPPER : (best >= window_beta) ? TT_LOWER : TT_EXACT;
+        tt->store(key, best, empties, bound, best_move);
+    }
+    return best;
+}
+
+// exact value of the position after player moved to board, in heuristic()'s orientation (positive is good for
+// black) but counting final discs
+int solveAfterMove(char board[8][8], char player, int alpha, int beta, SearchContext & ctx){
+    uint64_t black, white;
+    toBitboards(board, black, white);
+    // the opponent moves next, so its window and value are the other way round
+    if(player == 'b')
+        return -solveEndgame(white, black, -beta, -alpha, false, ctx);
+    return solveEndgame(black, white, alpha, beta, false, ctx);
+}
+
+Line tablePrincipalVariation(const TranspositionTable & tt, char board[8][8], char player, uint8_t move, int length){
+    Line pv;
+    pv.moves[pv.length++] = move;
+    char position[8][8];
+    std::memcpy(position, board, 8 * 8 * sizeof(char));
+    makeMove(position, move / 8, move % 8, player);
+
+    char to_move = (player == 'b') ? 'w' : 'b';
+    while(pv.length < std::min(length, MAX_LINE)){
+        char other_player = (to_move == 'b') ? 'w' : 'b';
+        MoveList move_list = calculateLegalMoves(position, to_move);
+        if(move_list.empty()){
+            if(calculateLegalMoves(position, other_player).empty())
+                break;
+            pv.moves[pv.length++] = NO_MOVE;
+            to_move = other_player;
+            continue;
+        }
+
+        TTEntry entry;
+        if(!tt.probe(hashPosition(position, to_move), entry) || entry.move < 0 || !move_list.contains(entry.move))
+            break;
+        pv.moves[pv.length++] = static_cast<uint8_t>(entry.move);
+        makeMove(position, entry.move / 8, entry.move % 8, to_move);
+        to_move = other_player;
+    }
+    return pv;
+}
+
+// the solved line after player's move in board: each position's best move comes from the solver's table entries
+// or, once few enough empty squares are left, from solving the position's moves right here
+Line solverPrincipalVariation(char board[8][8], char player, uint8_t move, SearchContext & ctx){
+    Line pv;
+    pv.moves[pv.length++] = move;
+    uint64_t black, white;
+    char position[8][8];
+    std::memcpy(position, board, 8 * 8 * sizeof(char));
+    makeMove(position, move / 8, move % 8, player);
+    toBitboards(position, black, white);
+
+    // own is the side to move
+    uint64_t own = (player == 'b') ? white : black;
+    uint64_t opp = (player == 'b') ? black : white;
+    while(pv.length < MAX_LINE && !ctx.aborted){
+        uint64_t moves = bitboardMoves(own, opp);
+        if(moves == 0){
+            if(bitboardMoves(opp, own) == 0)
+                break; // game over
+            pv.moves[pv.length++] = NO_MOVE;
+            std::swap(own, opp);
+            continue;
+        }
+
+        TTEntry entry;
+        int square = -1;
+        if(ctx.config->tt != NULL && ctx.config->tt->probe(solverKey(own, opp), entry) && entry.move >= 0
+           && (moves & (uint64_t(1) << entry.move))){
+            square = entry.move;
+        } else if(__builtin_popcountll(~(own | opp)) < SOLVER_TT_EMPTIES){
+            int best = -65;
+            for(; moves != 0; moves &= moves - 1){
+                int candidate = __builtin_ctzll(moves);
+                uint64_t flipped = bitboardFlips(own, opp, candidate);
+                int score = -solveEndgame(opp & ~flipped, own | flipped | (uint64_t(1) << candidate), -65, 65, false, ctx);
+                if(score > best){
+                    best = score;
+                    square = candidate;
+                }
+            }
+        } else {
+            break; // the table lost the position
+        }
+
+        uint64_t flipped = bitboardFlips(own, opp, square);
+        uint64_t next_own = opp & ~flipped;
+        opp = own | flipped | (uint64_t(1) << square);
+        own = next_own;
+        pv.moves[pv.length++] = static_cast<uint8_t>(square);
+    }
+    return pv;
+}
+
+SearchResult search(char board[8][8], char player, const SearchLimits & limits, const EngineConfig & config,
+                    const std::atomic<bool> & stop, const std::function<void(const SearchResult &)> & on_iteration){
+    SearchContext ctx;
+    ctx.config = &config;
+    ctx.stop = &stop;
+    ctx.start = std::chrono::steady_clock::now();
+    ctx.has_deadline = limits.time_ms > 0;
+    ctx.deadline = ctx.start + std::chrono::milliseconds(limits.time_ms);
+
+    SearchResult result;
+    MoveList move_list = calculateLegalMoves(board, player);
+    if(move_list.empty())
+        return result;
+
+    // a table kept from the previous move usually knows the best move already, search it first
+    if(config.tt != NULL){
+        TTEntry entry;
+        if(config.tt->probe(hashPosition(board, player), entry) && entry.move >= 0)
+            move_list.moveSquareToFront(entry.move);
+    }
+    result.move = move_list.squares[0]; // answer with some legal move even if not a single iteration completes
+    result.pv.moves[0] = result.move;
+    result.pv.length = 1;
+
+    // close to the end of the game the exact result is within reach, no need to search iteratively; a depth limit
+    // short of the end of the game still gets a depth-limited search (see engineLimits())
+    int empties = emptySquares(board);
+    if(config.endgame > 0 && empties <= config.endgame && limits.depth >= empties){
+        bool maximizing_player = (player == 'b');
+        int alpha = -65, beta = 65;
+        for(int i = 0; i < move_list.size(); ++i){
+            char child[8][8];
+            std::memcpy(child, board, 8 * 8 * sizeof(char));
+            makeMove(child, move_list.row(i), move_list.col(i), player);
+
+            int eval = solveAfterMove(child, player, alpha, beta, ctx);
+            if(ctx.aborted)
+                break;
+
+            // a stopped solve still answers with the best of the moves solved so far
+            if(i == 0 || (maximizing_player ? eval > result.score : eval < result.score)){
+                result.move = move_list.squares[i];
+                result.pv.moves[0] = result.move;
+                result.score = eval;
+            }
+            if(maximizing_player)
+                alpha = std::max(alpha, eval);
+            else
+                beta = std::min(beta, eval);
+        }
+
+        if(!ctx.aborted)
+            result.pv = solverPrincipalVariation(board, player, result.move, ctx);
+        result.nodes = ctx.nodes;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx.start).count();
+        if(!ctx.aborted){
+            result.depth = empties;
+            if(on_iteration)
+                on_iteration(result);
+        }
+        return result;
+    }
+
+    for(int depth = 1; depth <= limits.depth; ++depth){
+        int best_score = 0;
+        if(config.mtdf && depth > 1){
+            best_score = mtdf(board, player, move_list, depth, result.score, ctx);
+        } else {
+            // expect the score of the previous iteration: a narrow window around it prunes far more than a full
+            // one, and a score outside the window is searched again with the window widened on that side
+            int delta = config.aspiration;
+            int alpha = -99999999, beta = 99999999;
+            if(depth > 1 && delta > 0){
+                alpha = result.score - delta;
+                beta = result.score + delta;
+            }
+
+            while(true){
+                int best_index = 0;
+                best_score = searchRoot(board, player, move_list, depth, alpha, beta, ctx, best_index);
+                if(ctx.aborted)
+                    break;
+
+                // the best (or refuting) move goes first, for a re-search as well as for the next iteration
+                move_list.moveToFront(best_index);
+
+                delta *= 2;
+                if(best_score <= alpha)
+                    alpha = std::max(best_score - delta, -99999999);
+                else if(best_score >= beta)
+                    beta = std::min(best_score + delta, 99999999);
+                else
+                    break;
+            }
+        }
+
+        if(ctx.aborted)
+            break;
+
+        result.move = move_list.squares[0];
+        if(config.tt != NULL){
+            result.pv = tablePrincipalVariation(*config.tt, board, player, result.move, depth);
+        } else {
+            result.pv.moves[0] = result.move;
+            result.pv.length = 1;
+        }
+        result.score = best_score;
+        result.depth = depth;
+        result.nodes = ctx.nodes;
+        result.etc_cutoffs = ctx.etc_cutoffs;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx.start).count();
+        if(on_iteration)
+            on_iteration(result);
+
+        // a stop requested during the iteration (or by on_iteration) ends the search here, not in the next iteration
+        if(stop.load(std::memory_order_relaxed))
+            break;
+
+        // nothing left to search once the whole game tree fits into the depth
+        if(depth >= 60)
+            break;
+    }
+
+    result.nodes = ctx.nodes;
+    result.etc_cutoffs = ctx.etc_cutoffs;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx.start).count();
+    return result;
+}
+
+std::vector<MoveScore> scoreMoves(char board[8][8], char player, const SearchLimits & limits, const EngineConfig & config,
+                                  const std::atomic<bool> & stop, int multi_pv){
+    SearchContext ctx;
+    ctx.config = &config;
+    ctx.stop = &stop;
+    ctx.start = std::chrono::steady_clock::now();
+    ctx.has_deadline = limits.time_ms > 0;
+    ctx.deadline = ctx.start + std::chrono::milliseconds(limits.time_ms);
+
+    bool maximizing_player = (player == 'b');
+    std::vector<MoveScore> scores;
+    for(int square : calculateLegalMoves(board, player))
+        scores.push_back(MoveScore{static_cast<uint8_t>(square), 0});
+    if(multi_pv <= 0)
+        multi_pv = static_cast<int>(scores.size());
+
+    auto better = [&](const MoveScore & a, const MoveScore & b){
+        if(a.score != b.score)
+            return maximizing_player ? a.score > b.score : a.score < b.score;
+        return a.exact && !b.exact;
+    };
+
+    // solved exactly in a single pass close to the end of the game, if the depth limit allows it (see search())
+    int empties = emptySquares(board);
+    bool solve = config.endgame > 0 && empties <= config.endgame && limits.depth >= empties;
+    for(int depth = 1; depth <= limits.depth && depth <= 60; ++depth){
+        // moves in the order of the previous iteration, so the best ones are likely searched first
+        std::vector<MoveScore> iteration = scores;
+        std::vector<int> best; // exact scores found so far, best first
+        for(auto & entry : iteration){
+            char child[8][8];
+            std::memcpy(child, board, 8 * 8 * sizeof(char));
+            makeMove(child, entry.move / 8, entry.move % 8, player);
+            auto value = [&](int alpha, int beta){
+                if(solve)
+                    return solveAfterMove(child, player, std::max(alpha, -65), std::min(beta, 65), ctx);
+                return alphaBeta(child, depth - 1, alpha, beta, !maximizing_player, ctx);
+            };
+
+            // once multi_pv moves have exact scores a zero window at the worst of them tells whether this move
+            // is better, only then is it searched again with a full window
+            entry.exact = true;
+            if(static_cast<int>(best.size()) >= multi_pv){
+                int threshold = best[multi_pv - 1];
+                entry.score = maximizing_player ? value(threshold, threshold + 1) : value(threshold - 1, threshold);
+                entry.exact = maximizing_player ? entry.score > threshold : entry.score < threshold;
+            }
+            if(entry.exact && !ctx.aborted)
+                entry.score = value(-99999999, 99999999);
+            if(ctx.aborted)
+                break;
+
+            if(entry.exact){
+                best.insert(std::find_if(best.begin(), best.end(), [&](int score){
+                    return maximizing_player ? entry.score > score : entry.score < score;
+                }), entry.score);
+            }
+        }
+
+        if(ctx.aborted)
+            break;
+
+        std::stable_sort(iteration.begin(), iteration.end(), better);
+        scores = iteration;
+        if(solve)
+            break;
+    }
+    return scores;
+}
+
+void printLegalMoves(char player, const std::vector<MoveScore> & scores){
+    std::cout << ((player == 'b') ? "Black" : "White") << " legal moves (best first):\n";
+    int sign = (player == 'b') ? 1 : -1;
+    for(const MoveScore & entry : scores){
+        std::cout << "(" << entry.move / 8 << "," << entry.move % 8 << ") " << (entry.exact ? "" : "<=")
+                  << sign * entry.score << "  ";
+    }
+    std::cout << std::endl;
+}
+
+SearchLimits engineLimits(char board[8][8], const EngineConfig & config){
+    SearchLimits limits;
+    limits.depth = config.depth;
+    limits.time_ms = config.time_ms;
+    if(config.endgame > 0 && emptySquares(board) <= config.endgame)
+        limits.depth = std::max(limits.depth, emptySquares(board));
+    return limits;
+}
+
+uint8_t chooseMove(char board[8][8], char player, const EngineConfig & config){
+    // positions in the opening book need no search at all
+    if(config.book != NULL){
+        uint8_t book_move = probeBook(*config.book, board, player);
+        if(book_move != NO_MOVE)
+            return book_move;
+    }
+
+    if(config.tt != NULL)
+        config.tt->newSearch();
+
+    if(config.alpha_beta){
+        std::atomic<bool> stop(false);
+        SearchResult result = search(board, player, engineLimits(board, config), config, stop);
+        if(DEBUG_MODE){
+            std::cout << "DEBUG: AI searched " << result.nodes << " positions to depth " << result.depth
+                      << " (" << result.etc_cutoffs << " transposition cutoffs), optimal value = " << result.score
+                      << ", principal variation:";
+            for(int i = 0; i < result.pv.length; ++i)
+                std::cout << ' ' << ((result.pv.moves[i] == NO_MOVE) ? std::string("pass")
+                                                                     : squareName(result.pv.moves[i] / 8, result.pv.moves[i] % 8));
+            std::cout << "\n\n";
+        }
+        return result.move;
+    }
+
+    GameTree gametree(board, config.depth, player); // game tree representing config.depth decisions
+    Node & root = gametree.root();
+    bool maximizer = (player == 'b') ? true : false;
+
+    // find optimal value, the search hands back the line leading to it
+    Line pv;
+    int optimial_val = minimax(gametree, root, config.depth, maximizer, pv, config.weights);
+
+    if(DEBUG_MODE){
+        std::cout << "DEBUG: AI considered " << static_cast<int>(root.child_count) << " initial moves for this board configuration ("
+                  << gametree.size() << " nodes).\n";
+        printLegalMoves(board, player);
+        // the tree is searched without pruning, so every root child holds its minimax value
+        for(int i = 0; i < root.child_count; ++i){
+            std::cout << "\t" << i << "th node's heuristic value = " << gametree.child(root, i).val << '\n';
+        }
+        std::cout << "DEBUG: optimal value = " << optimial_val << ", principal variation:";
+        for(int i = 0; i < pv.length; ++i)
+            std::cout << ' ' << ((pv.moves[i] == NO_MOVE) ? std::string("pass") : squareName(pv.moves[i] / 8, pv.moves[i] % 8));
+        std::cout << "\n\n";
+    }
+
+    // the first move of the principal variation is the best one, a pass (or a finished game) leaves no move
+    if(pv.length == 0)
+        return NO_MOVE;
+    return pv.moves[0];
+}
+
+void Ponderer::start(char board[8][8], char opponent, const EngineConfig & config){
+    stop();
+    ready_.clear();
+    stop_ = false;
+
+    // the opponent's move is a move of the game, all replies are searched in the same generation so that none of
+    // them pushes out the others (or the engine's previous search)
+    if(config.tt != NULL)
+        config.tt->newSearch();
+
+    char position[8][8];
+    std::memcpy(position, board, 8 * 8 * sizeof(char));
+    thread_ = std::thread([this, position, opponent, config]() mutable {
+        char engine_player = (opponent == 'w') ? 'b' : 'w';
+        MoveList replies = calculateLegalMoves(position, opponent);
+
+        // the engine's last search usually left the opponent's best move in the table, expect that one first
+        TTEntry entry;
+        if(config.tt != NULL && config.tt->probe(hashPosition(position, opponent), entry) && entry.move >= 0)
+            replies.moveSquareToFront(entry.move);
+
+        for(int reply : replies){
+            ReadyMove ready;
+            std::memcpy(ready.board, position, 8 * 8 * sizeof(char));
+            makeMove(ready.board, reply / 8, reply % 8, opponent);
+
+            SearchResult result = search(ready.board, engine_player, engineLimits(ready.board, config), config, stop_);
+            if(stop_)
+                return;
+
+            // no move means the engine has to pass after this reply, nothing to prepare
+            if(result.move != NO_MOVE){
+                ready.move = result.move;
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_.push_back(ready);
+            }
+        }
+    });
+}
+
+uint8_t Ponderer::readyMove(char board[8][8]){
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(const auto & ready : ready_){
+        if(std::memcmp(ready.board, board, 8 * 8 * sizeof(char)) == 0)
+            return ready.move;
+    }
+    return NO_MOVE;
+}
+
+EngineConfig parseEngineConfig(const std::string & spec){
+    EngineConfig config;
+    std::string::size_type start = 0;
+    while(start < spec.size()){
+        std::string::size_type end = spec.find(',', start);
+        if(end == std::string::npos)
+            end = spec.size();
+
+        std::string item = spec.substr(start, end - start);
+        std::string::size_type eq = item.find('=');
+        if(eq == std::string::npos)
+            throw std::invalid_argument{"parseEngineConfig(): expected key=value, got \"" + item + "\""};
+
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        if(key == "name")
+            config.name = value;
+        else if(key == "depth")
+            config.depth = std::stoi(value);
+        else if(key == "time")
+            config.time_ms = std::stoi(value);
+        else if(key == "alphabeta")
+            config.alpha_beta = (std::stoi(value) != 0);
+        else if(key == "mobility")
+            config.weights.mobility = std::stoi(value);
+        else if(key == "disc")
+            config.weights.disc = std::stoi(value);
+        else if(key == "corner")
+            config.weights.corner = std::stoi(value);
+        else if(key == "tt")
+            config.tt_megabytes = std::stoi(value);
+        else if(key == "aspiration")
+            config.aspiration = std::stoi(value);
+        else if(key == "mtdf")
+            config.mtdf = (std::stoi(value) != 0);
+        else if(key == "probcut")
+            config.probcut = std::stod(value);
+        else if(key == "endgame")
+            config.endgame = std::stoi(value);
+        else if(key == "etc")
+            config.etc_depth = std::stoi(value);
+        else
+            throw std::invalid_argument{"parseEngineConfig(): unknown key \"" + key + "\""};
+
+        start = end + 1;
+    }
+
+    if(config.depth < 1)
+        throw std::invalid_argument{"parseEngineConfig(): depth must be at least 1"};
+    if(config.tt_megabytes < 0)
+        throw std::invalid_argument{"parseEngineConfig(): tt must not be negative"};
+    if(config.endgame < 0 || config.endgame > 60)
+        throw std::invalid_argument{"parseEngineConfig(): endgame must be 0-60"};
+
+    return config;
+}
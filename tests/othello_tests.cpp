@@ -0,0 +1,365 @@
+// checks of the engine against slow but obviously correct references; every group is one ctest test (see
+// CMakeLists.txt), `othello_tests <group>` runs a single group and `othello_tests` all of them
+
+#include "othello/othello.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char * expression, const char * file, int line){
+    if(ok)
+        return;
+    std::cerr << file << ':' << line << ": check failed: " << expression << '\n';
+    ++failures;
+}
+
+// not assert(): release builds define NDEBUG, and the tests run on release builds
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+char opponentOf(char player){
+    return (player == 'w') ? 'b' : 'w';
+}
+
+// play random moves from the start position until empties squares are left and player has a move there; false if
+// the game ended before
+bool randomPosition(std::mt19937 & rng, int empties, char (&board)[8][8], char & player){
+    initializeBoard(board);
+    player = 'b';
+    while(true){
+        MoveList move_list = calculateLegalMoves(board, player);
+        if(move_list.empty()){
+            if(calculateLegalMoves(board, opponentOf(player)).empty())
+                return false;
+            player = opponentOf(player);
+            continue;
+        }
+        if(emptySquares(board) == empties)
+            return true;
+        int i = std::uniform_int_distribution<int>(0, move_list.size() - 1)(rng);
+        makeMove(board, move_list.row(i), move_list.col(i), player);
+        player = opponentOf(player);
+    }
+}
+
+// leaves of the game tree depth plies deep, a pass counts as a ply and a finished game as a leaf
+long long perft(char board[8][8], char player, int depth){
+    if(depth == 0)
+        return 1;
+    MoveList move_list = calculateLegalMoves(board, player);
+    if(move_list.empty()){
+        if(calculateLegalMoves(board, opponentOf(player)).empty())
+            return 1;
+        return perft(board, opponentOf(player), depth - 1);
+    }
+    long long leaves = 0;
+    for(int i = 0; i < move_list.size(); ++i){
+        char child[8][8];
+        std::memcpy(child, board, 8 * 8 * sizeof(char));
+        makeMove(child, move_list.row(i), move_list.col(i), player);
+        leaves += perft(child, opponentOf(player), depth - 1);
+    }
+    return leaves;
+}
+
+// final disc difference (black - white) with perfect play, by visiting every line of the game
+int bruteForce(char board[8][8], char player){
+    MoveList move_list = calculateLegalMoves(board, player);
+    if(move_list.empty()){
+        if(calculateLegalMoves(board, opponentOf(player)).empty())
+            return getScore(board, 'b') - getScore(board, 'w');
+        return bruteForce(board, opponentOf(player));
+    }
+    int best = (player == 'b') ? -65 : 65;
+    for(int i = 0; i < move_list.size(); ++i){
+        char child[8][8];
+        std::memcpy(child, board, 8 * 8 * sizeof(char));
+        makeMove(child, move_list.row(i), move_list.col(i), player);
+        int score = bruteForce(child, opponentOf(player));
+        best = (player == 'b') ? std::max(best, score) : std::min(best, score);
+    }
+    return best;
+}
+
+// write a file of a 16 byte header (magic, count) followed by 16 zero bytes
+bool writeHeader(const char * path, const char (&magic)[9], uint64_t count){
+    std::ofstream out(path, std::ios::binary);
+    const char zeros[16] = {};
+    out.write(magic, 8);
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    out.write(zeros, sizeof(zeros));
+    return static_cast<bool>(out);
+}
+
+bool sameBoard(const char (&a)[8][8], const char (&b)[8][8]){
+    return std::memcmp(a, b, 8 * 8 * sizeof(char)) == 0;
+}
+
+void testMoveGeneration(){
+    char board[8][8];
+    initializeBoard(board);
+    MoveList move_list = calculateLegalMoves(board, 'b');
+    CHECK(move_list.size() == 4);
+    for(int square : {19, 26, 37, 44}) // d3, c4, f5, e6
+        CHECK(isLegalMove(board, move_list, square / 8, square % 8, 'b'));
+
+    const long long PERFT[] = {1, 4, 12, 56, 244, 1396, 8200, 55092, 390216};
+    for(int depth = 0; depth <= 8; ++depth)
+        CHECK(perft(board, 'b', depth) == PERFT[depth]);
+
+    // flipMask() predicts exactly the discs makeMove() flips
+    std::mt19937 rng(1);
+    for(int game = 0; game < 20; ++game){
+        char player;
+        if(!randomPosition(rng, 60 - game * 3, board, player))
+            continue;
+        move_list = calculateLegalMoves(board, player);
+        for(int i = 0; i < move_list.size(); ++i){
+            char child[8][8];
+            std::memcpy(child, board, 8 * 8 * sizeof(char));
+            makeMove(child, move_list.row(i), move_list.col(i), player);
+            uint64_t changed = 0;
+            for(int square = 0; square < 64; ++square)
+                if(child[square / 8][square % 8] != board[square / 8][square % 8] && square != move_list.squares[i])
+                    changed |= uint64_t(1) << square;
+            CHECK(flipMask(board, move_list.row(i), move_list.col(i), player) == changed);
+        }
+    }
+}
+
+void testEndgame(){
+    std::mt19937 rng(2);
+    TranspositionTable tt(16);
+    int positions = 0;
+    while(positions < 9){
+        char board[8][8];
+        char player;
+        if(!randomPosition(rng, 8 + positions % 3, board, player))
+            continue;
+        ++positions;
+
+        int expected = bruteForce(board, player);
+        SearchLimits limits;
+        limits.depth = 60;
+        EngineConfig config;
+        std::atomic<bool> stop(false);
+        CHECK(search(board, player, limits, config, stop).score == expected);
+        config.tt = &tt; // the solver's table kicks in at SOLVER_TT_EMPTIES
+        CHECK(search(board, player, limits, config, stop).score == expected);
+
+        // the exact scores of every move agree with the best one
+        int best = (player == 'b') ? -65 : 65;
+        for(const MoveScore & move : scoreMoves(board, player, limits, config, stop, 64)){
+            CHECK(move.exact);
+            best = (player == 'b') ? std::max(best, move.score) : std::min(best, move.score);
+        }
+        CHECK(best == expected);
+    }
+}
+
+void testSearchVariants(){
+    std::mt19937 rng(3);
+    for(int position = 0; position < 6; ++position){
+        char board[8][8];
+        char player;
+        if(!randomPosition(rng, 40 - position * 3, board, player)){
+            --position;
+            continue;
+        }
+
+        // full-window alpha-beta without a table is the reference, every variant must find its value
+        EngineConfig plain;
+        plain.aspiration = 0;
+        plain.probcut = 0;
+        plain.endgame = 0;
+        plain.etc_depth = 0;
+        SearchLimits limits;
+        limits.depth = 6;
+        std::atomic<bool> stop(false);
+        int expected = search(board, player, limits, plain, stop).score;
+
+        TranspositionTable tt(4);
+        EngineConfig variants[4] = {plain, plain, plain, plain};
+        variants[0].aspiration = ASPIRATION_WINDOW;
+        variants[1].aspiration = 1; // fails high or low on almost every iteration
+        variants[2].mtdf = true;
+        variants[2].tt = &tt;
+        variants[3].etc_depth = 2;
+        variants[3].tt = &tt;
+        for(const EngineConfig & config : variants){
+            tt.clear();
+            CHECK(search(board, player, limits, config, stop).score == expected);
+        }
+    }
+
+    // no position has more than 60 empty squares, a larger endgame setting is a mistake
+    bool rejected = false;
+    try{
+        parseEngineConfig("endgame=61");
+    } catch(const std::invalid_argument &){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+void testSymmetry(){
+    std::mt19937 rng(4);
+    for(int position = 0; position < 20; ++position){
+        char board[8][8];
+        char player;
+        if(!randomPosition(rng, 58 - position * 2, board, player))
+            continue;
+
+        int transform;
+        uint64_t hash = canonicalHash(board, player, transform);
+        uint64_t black, white;
+        toBitboards(board, black, white);
+        for(int t = 0; t < 8; ++t){
+            char variant[8][8];
+            fromBitboards(transformBitboard(black, t), transformBitboard(white, t), variant);
+            CHECK(canonicalHash(variant, player, transform) == hash);
+            CHECK(canonicalHash(variant, opponentOf(player), transform) != hash);
+            for(int square = 0; square < 64; ++square)
+                CHECK(untransformSquare(transformSquare(square, t), t) == square);
+        }
+    }
+}
+
+void testPackedPositions(){
+    std::mt19937 rng(5);
+    for(int position = 0; position < 50; ++position){
+        char board[8][8];
+        char player;
+        if(!randomPosition(rng, 59 - position, board, player))
+            continue;
+        for(char side : {'b', 'w'}){
+            PackedPosition packed;
+            CHECK(packPosition(board, side, packed));
+            char unpacked[8][8];
+            char unpacked_player;
+            unpackPosition(packed, unpacked, unpacked_player);
+            CHECK(sameBoard(board, unpacked));
+            CHECK(unpacked_player == side);
+        }
+    }
+
+    char board[8][8];
+    initializeBoard(board);
+    board[3][3] = '-';
+    PackedPosition packed;
+    CHECK(!packPosition(board, 'b', packed));
+
+    // a record count whose size in bytes wraps around must not pass for a file that holds the records
+    const uint64_t wrapping_count = uint64_t(1) << 60;
+    CHECK(writeHeader("othello_tests_book.bin", "OTHBOOK2", wrapping_count));
+    OpeningBook book;
+    CHECK(!book.open("othello_tests_book.bin"));
+    std::remove("othello_tests_book.bin");
+
+    CHECK(writeHeader("othello_tests_positions.pos", "OTHPOS01", wrapping_count));
+    PositionFileReader positions;
+    CHECK(!positions.open("othello_tests_positions.pos"));
+    std::remove("othello_tests_positions.pos");
+}
+
+void testHistory(){
+    std::mt19937 rng(6);
+    char board[8][8];
+    initializeBoard(board);
+    char player = 'b';
+
+    // every board of a random game (passes included), to compare the history's boards with
+    GameHistory history;
+    char boards[128][8][8];
+    char players[128];
+    int plies = 0;
+    while(true){
+        std::memcpy(boards[plies], board, 8 * 8 * sizeof(char));
+        players[plies++] = player;
+        MoveList move_list = calculateLegalMoves(board, player);
+        if(move_list.empty()){
+            if(calculateLegalMoves(board, opponentOf(player)).empty())
+                break;
+            history.pass(player);
+        } else {
+            int i = std::uniform_int_distribution<int>(0, move_list.size() - 1)(rng);
+            history.play(board, move_list.row(i), move_list.col(i), player);
+        }
+        player = opponentOf(player);
+    }
+    CHECK(history.length() == plies - 1);
+
+    while(history.undo(board, player)){
+        CHECK(sameBoard(board, boards[history.ply()]));
+        CHECK(player == players[history.ply()]);
+    }
+    CHECK(history.ply() == 0);
+    while(history.redo(board, player)){
+        CHECK(sameBoard(board, boards[history.ply()]));
+        CHECK(player == players[history.ply()]);
+    }
+    CHECK(history.ply() == history.length());
+
+    for(int jump = 0; jump < 50; ++jump){
+        int ply = std::uniform_int_distribution<int>(0, history.length())(rng);
+        CHECK(history.goTo(board, player, ply));
+        CHECK(sameBoard(board, boards[ply]));
+        CHECK(player == players[ply]);
+    }
+    CHECK(!history.goTo(board, player, history.length() + 1));
+
+    // playing the recorded move keeps the rest of the game, any other move replaces it
+    int length = history.length();
+    history.goTo(board, player, 0);
+    const HistoryEntry & first = history[0];
+    history.play(board, first.square / 8, first.square % 8, first.player);
+    CHECK(history.length() == length);
+    CHECK(sameBoard(board, boards[1]));
+    history.goTo(board, player, 0);
+    int other = (first.square == 19) ? 26 : 19;
+    history.play(board, other / 8, other % 8, player);
+    CHECK(history.length() == 1);
+}
+
+struct TestGroup
+{
+    const char * name;
+    void (*run)();
+};
+
+const TestGroup TEST_GROUPS[] = {
+    {"movegen", testMoveGeneration},
+    {"endgame", testEndgame},
+    {"search", testSearchVariants},
+    {"symmetry", testSymmetry},
+    {"files", testPackedPositions},
+    {"history", testHistory},
+};
+
+} // namespace
+
+int main(int argc, char * argv[]){
+    bool found = false;
+    for(const TestGroup & group : TEST_GROUPS){
+        if(argc > 1 && std::string(argv[1]) != group.name)
+            continue;
+        found = true;
+        int before = failures;
+        group.run();
+        std::cout << group.name << ": " << ((failures == before) ? "ok" : "FAILED") << '\n';
+    }
+    if(!found){
+        std::cerr << "unknown test group " << argv[1] << '\n';
+        return 1;
+    }
+    return (failures == 0) ? 0 : 1;
+}